@@ -0,0 +1,74 @@
+// fms_fft.h - radix 2 fast Fourier transform
+#pragma once
+#include <cmath>
+#include <complex>
+#include <span>
+#include <vector>
+#include "fms_ensure.h"
+
+namespace fms::fft {
+
+	// smallest power of 2 not less than n
+	inline size_t pow2(size_t n)
+	{
+		size_t m = 1;
+		while (m < n) {
+			m <<= 1;
+		}
+
+		return m;
+	}
+
+	// In place a_j <- sum_k a_k exp(-2 pi i jk/n) for n = a.size() a power of 2.
+	// The inverse uses exp(2 pi i jk/n) and divides by n.
+	// Twiddle factors are computed directly, not by repeated multiplication, so the error is O(log n) ulp.
+	template<class X>
+	inline void transform(std::span<std::complex<X>> a, bool inverse = false)
+	{
+		static constexpr X pi = X(3.14159265358979323846);
+		const size_t n = a.size();
+		ensure((n & (n - 1)) == 0);
+
+		if (n < 2) {
+			return;
+		}
+
+		// bit reversal permutation
+		for (size_t i = 1, j = 0; i < n; ++i) {
+			size_t bit = n >> 1;
+			for (; j & bit; bit >>= 1) {
+				j ^= bit;
+			}
+			j ^= bit;
+			if (i < j) {
+				std::swap(a[i], a[j]);
+			}
+		}
+
+		std::vector<std::complex<X>> w(n / 2);
+		for (size_t k = 0; k < n / 2; ++k) {
+			X t = 2 * pi * X(k) / X(n);
+			w[k] = std::complex<X>(cos(t), inverse ? sin(t) : -sin(t));
+		}
+
+		for (size_t len = 2; len <= n; len <<= 1) {
+			size_t stride = n / len;
+			for (size_t i = 0; i < n; i += len) {
+				for (size_t k = 0; k < len / 2; ++k) {
+					// multiply in reals, std::complex operator* checks for infinities
+					std::complex<X> u = a[i + k], b = a[i + k + len / 2], wk = w[k * stride];
+					std::complex<X> v(b.real() * wk.real() - b.imag() * wk.imag(), b.real() * wk.imag() + b.imag() * wk.real());
+					a[i + k] = u + v;
+					a[i + k + len / 2] = u - v;
+				}
+			}
+		}
+
+		if (inverse) {
+			for (auto& ai : a) {
+				ai /= X(n);
+			}
+		}
+	}
+
+}
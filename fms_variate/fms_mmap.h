@@ -0,0 +1,168 @@
+// fms_mmap.h - memory mapped files
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <utility>
+#include "fms_ensure.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fms::mmap {
+
+	// Map an entire file into memory. Pages are read from the file on first access
+	// and shared with other processes mapping the same file.
+	class view {
+		void* p = nullptr;
+		size_t n = 0;
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE map = nullptr;
+#else
+		int fd = -1;
+#endif
+		void close()
+		{
+#if defined(_WIN32)
+			if (p) {
+				UnmapViewOfFile(p);
+			}
+			if (map) {
+				CloseHandle(map);
+			}
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+			}
+			map = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (p) {
+				munmap(p, n);
+			}
+			if (fd != -1) {
+				::close(fd);
+			}
+			fd = -1;
+#endif
+			p = nullptr;
+			n = 0;
+		}
+	public:
+		view() = default;
+		// Map path read only, or read write after creating or resizing it to size bytes if size > 0.
+		view(const std::filesystem::path& path, size_t size = 0)
+		{
+			bool write = size > 0;
+			// release the file and mapping if any step fails
+			try {
+#if defined(_WIN32)
+				file = CreateFileW(path.c_str(), write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+					FILE_SHARE_READ, nullptr, write ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				ensure(file != INVALID_HANDLE_VALUE);
+				LARGE_INTEGER size_;
+				if (write) {
+					size_.QuadPart = static_cast<LONGLONG>(size);
+				}
+				else {
+					ensure(GetFileSizeEx(file, &size_));
+				}
+				n = static_cast<size_t>(size_.QuadPart);
+				if (n > 0) {
+					map = CreateFileMappingW(file, nullptr, write ? PAGE_READWRITE : PAGE_READONLY,
+						size_.HighPart, size_.LowPart, nullptr);
+					ensure(map != nullptr);
+					p = MapViewOfFile(map, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, n);
+					ensure(p != nullptr);
+				}
+#else
+				fd = ::open(path.c_str(), write ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+				ensure(fd != -1);
+				if (write) {
+					ensure(ftruncate(fd, static_cast<off_t>(size)) == 0);
+					n = size;
+				}
+				else {
+					struct stat st;
+					ensure(fstat(fd, &st) == 0);
+					n = static_cast<size_t>(st.st_size);
+				}
+				if (n > 0) {
+					p = ::mmap(nullptr, n, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+					if (p == MAP_FAILED) {
+						p = nullptr;
+					}
+					ensure(p != nullptr);
+				}
+#endif
+			}
+			catch (...) {
+				close();
+				throw;
+			}
+		}
+		view(const view&) = delete;
+		view& operator=(const view&) = delete;
+		view(view&& v) noexcept
+		{
+			*this = std::move(v);
+		}
+		view& operator=(view&& v) noexcept
+		{
+			if (this != &v) {
+				close();
+				std::swap(p, v.p);
+				std::swap(n, v.n);
+#if defined(_WIN32)
+				std::swap(file, v.file);
+				std::swap(map, v.map);
+#else
+				std::swap(fd, v.fd);
+#endif
+			}
+
+			return *this;
+		}
+		~view()
+		{
+			close();
+		}
+
+		size_t size() const
+		{
+			return n;
+		}
+		const std::byte* data() const
+		{
+			return static_cast<const std::byte*>(p);
+		}
+		std::byte* data()
+		{
+			return static_cast<std::byte*>(p);
+		}
+
+		// write modified pages to the file
+		void flush()
+		{
+			if (p) {
+#if defined(_WIN32)
+				ensure(FlushViewOfFile(p, n));
+				ensure(FlushFileBuffers(file));
+#else
+				ensure(msync(p, n, MS_SYNC) == 0);
+#endif
+			}
+		}
+	};
+
+}
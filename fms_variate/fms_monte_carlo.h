@@ -0,0 +1,282 @@
+// fms_monte_carlo.h - reproducible multi-threaded Monte Carlo, quasi Monte Carlo, and importance sampling over variates
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_parallel.h"
+#include "fms_random.h"
+#include "fms_random_sobol.h"
+#include "fms_variate.h"
+#include "fms_variate_sample.h"
+
+namespace fms::variate {
+
+	// count, mean, and sum of squared deviations from the mean
+	template<class X = double>
+	struct moments {
+		size_t n = 0;
+		X mean = 0;
+		X m2 = 0;
+
+		void add(X x)
+		{
+			++n;
+			X dx = x - mean;
+			mean += dx / X(n);
+			m2 += dx * (x - mean);
+		}
+		// combine with moments of a disjoint sample (Chan, Golub, and LeVeque)
+		moments& operator+=(const moments& m)
+		{
+			if (m.n != 0) {
+				X n_ = X(n), m_ = X(m.n), nm = X(n + m.n);
+				X d = m.mean - mean;
+				mean += d * m_ / nm;
+				m2 += m.m2 + d * d * n_ * m_ / nm;
+				n += m.n;
+			}
+
+			return *this;
+		}
+
+		X variance() const
+		{
+			return n > 1 ? m2 / X(n - 1) : 0;
+		}
+		// E[x^2]
+		X second() const
+		{
+			return n ? m2 / X(n) + mean * mean : 0;
+		}
+		// standard error of the mean
+		X error() const
+		{
+			return n ? sqrt(variance() / X(n)) : 0;
+		}
+	};
+
+	// moments of a pair and the sum of products of their deviations from the means
+	template<class X = double>
+	struct comoments {
+		moments<X> a, b;
+		X c = 0;
+
+		void add(X x, X y)
+		{
+			X dx = x - a.mean;
+			a.add(x);
+			b.add(y);
+			c += dx * (y - b.mean);
+		}
+		comoments& operator+=(const comoments& m)
+		{
+			if (m.a.n != 0) {
+				X n_ = X(a.n), m_ = X(m.a.n), nm = X(a.n + m.a.n);
+				c += m.c + (m.a.mean - a.mean) * (m.b.mean - b.mean) * n_ * m_ / nm;
+				a += m.a;
+				b += m.b;
+			}
+
+			return *this;
+		}
+
+		X covariance() const
+		{
+			return a.n > 1 ? c / X(a.n - 1) : 0;
+		}
+	};
+
+	static inline const char monte_carlo_doc[] = R"xyzyx(
+Estimate \(E_s[f(X)]\) for one or more payoffs \(f\) using draws from the Esscher transformed variate.
+Paths are split into fixed size chunks that threads take as they become idle. Each chunk has its own
+counter based random stream keyed by the seed and its first path, and chunk estimates are combined in
+chunk order, so results are bit identical for any number of threads.
+)xyzyx";
+	template<class X = double>
+	class monte_carlo {
+		uint64_t seed;
+		size_t chunk; // paths per chunk
+		unsigned threads; // 0 for all cores
+	public:
+		monte_carlo(uint64_t seed = 0, size_t chunk = 1 << 14, unsigned threads = 0)
+			: seed(seed), chunk(chunk), threads(threads)
+		{
+			ensure(chunk > 0);
+		}
+
+		// moments of f(X_s) for each payoff f over paths draws
+		template<variate_concept V, class... F>
+		std::array<moments<X>, sizeof...(F)> operator()(const V& v, size_t paths, typename V::stype s, const F&... f) const
+		{
+			constexpr size_t K = sizeof...(F);
+			size_t n = (paths + chunk - 1) / chunk;
+			std::vector<std::array<moments<X>, K>> part(n);
+
+			parallel::for_each(n, [&](size_t j) {
+				thread_local std::vector<X> x;
+				size_t begin = j * chunk;
+				x.resize(std::min(chunk, paths - begin));
+
+				random::philox g(seed, begin);
+				sample(v, g, std::span<X>(x), s);
+
+				std::array<moments<X>, K> m;
+				for (X xi : x) {
+					size_t k = 0;
+					(m[k++].add(X(f(xi))), ...);
+				}
+				part[j] = m;
+			}, threads);
+
+			std::array<moments<X>, K> result;
+			for (const auto& m : part) {
+				for (size_t k = 0; k < K; ++k) {
+					result[k] += m[k];
+				}
+			}
+
+			return result;
+		}
+	};
+
+	static inline const char quasi_monte_carlo_doc[] = R"xyzyx(
+Estimate \(E_s[f(X)]\) using independently scrambled Sobol sequences mapped through the quantile of \(X_s\).
+Each replicate averages \(f\) over the same number of points and the replicate averages are
+independent and unbiased, so their mean is the estimate and their standard error is an error estimate.
+For smooth \(f\) the error decreases nearly as \(1/N\) in the number of points instead of \(1/\sqrt{N}\).
+Use a power of 2 for the number of points.
+)xyzyx";
+	template<class X = double>
+	class quasi_monte_carlo {
+		uint64_t seed;
+		size_t replicates;
+		size_t chunk; // points per call to quantile
+		unsigned threads; // 0 for all cores
+	public:
+		quasi_monte_carlo(uint64_t seed = 0, size_t replicates = 16, size_t chunk = 1 << 14, unsigned threads = 0)
+			: seed(seed), replicates(replicates), chunk(chunk), threads(threads)
+		{
+			ensure(replicates > 0);
+			ensure(chunk > 0);
+		}
+
+		// moments over replicates of the average of f(X_s) over points for each payoff f
+		template<variate_concept V, class... F>
+		std::array<moments<X>, sizeof...(F)> operator()(const V& v, size_t points, typename V::stype s, const F&... f) const
+		{
+			constexpr size_t K = sizeof...(F);
+			std::vector<std::array<moments<X>, K>> part(replicates);
+
+			parallel::for_each(replicates, [&](size_t r) {
+				thread_local std::vector<X> x;
+				random::sobol q(1, random::sobol::scramble::owen, random::philox(seed, r)());
+
+				std::array<moments<X>, K> m;
+				for (size_t begin = 0; begin < points; begin += chunk) {
+					x.resize(std::min(chunk, points - begin));
+					sample(v, q, std::span<X>(x), s);
+					for (X xi : x) {
+						size_t k = 0;
+						(m[k++].add(X(f(xi))), ...);
+					}
+				}
+				part[r] = m;
+			}, threads);
+
+			std::array<moments<X>, K> result;
+			for (const auto& m : part) {
+				for (size_t k = 0; k < K; ++k) {
+					result[k].add(m[k].mean);
+				}
+			}
+
+			return result;
+		}
+	};
+
+	// upper tail of X_s at x
+	template<class X = double>
+	struct tail {
+		X s; // Esscher transform used for sampling
+		size_t n; // paths
+		X probability, probability_error; // P_s(X > x) and its standard error
+		X shortfall, shortfall_error; // E_s[X | X > x] and its standard error
+	};
+
+	static inline const char importance_sampling_doc[] = R"xyzyx(
+Estimate \(P_s(X > x)\) and the expected shortfall \(E_s[X\mid X > x]\) by sampling from \(X_t\)
+where \(\kappa'(t) = x\), so the threshold is the mean of the sampling distribution, and reweighting
+each draw by \(dP_s/dP_t = \exp(-(t - s)X + \kappa(t) - \kappa(s))\).
+If \(x\) is not above the mean of \(X_s\) then \(t = s\) and this is plain Monte Carlo.
+Paths, chunks, and random streams are the same as <code>monte_carlo</code>.
+)xyzyx";
+	template<class X = double>
+	class importance_sampling {
+		uint64_t seed;
+		size_t chunk; // paths per chunk
+		unsigned threads; // 0 for all cores
+	public:
+		importance_sampling(uint64_t seed = 0, size_t chunk = 1 << 14, unsigned threads = 0)
+			: seed(seed), chunk(chunk), threads(threads)
+		{
+			ensure(chunk > 0);
+		}
+
+		template<variate_concept V, class S = typename V::stype>
+		tail<X> operator()(const V& v, X x, size_t paths, S s = 0) const
+		{
+			ensure(paths > 1);
+
+			S t = v.cumulant(s, 1) < x ? cumulant_solve(v, x, s) : s;
+			S dk = v.cumulant(t, 0) - v.cumulant(s, 0);
+			size_t n = (paths + chunk - 1) / chunk;
+			// weight and weight times X on X > x
+			std::vector<comoments<X>> part(n);
+
+			parallel::for_each(n, [&](size_t j) {
+				thread_local std::vector<X> y;
+				size_t begin = j * chunk;
+				y.resize(std::min(chunk, paths - begin));
+
+				random::philox g(seed, begin);
+				sample(v, g, std::span<X>(y), t);
+
+				comoments<X> m;
+				for (X yi : y) {
+					X w = yi > x ? X(exp(-(t - s) * yi + dk)) : X(0);
+					m.add(w, w * yi);
+				}
+				part[j] = m;
+			}, threads);
+
+			comoments<X> m;
+			for (const auto& p : part) {
+				m += p;
+			}
+
+			tail<X> result;
+			result.s = X(t);
+			result.n = paths;
+			result.probability = m.a.mean;
+			result.probability_error = m.a.error();
+			if (m.a.mean > 0) {
+				// delta method for the ratio of means
+				X e = m.b.mean / m.a.mean;
+				X var = m.b.variance() - 2 * e * m.covariance() + e * e * m.a.variance();
+				result.shortfall = e;
+				result.shortfall_error = sqrt(std::max(var, X(0)) / X(paths)) / m.a.mean;
+			}
+			else {
+				result.shortfall = std::numeric_limits<X>::quiet_NaN();
+				result.shortfall_error = std::numeric_limits<X>::quiet_NaN();
+			}
+
+			return result;
+		}
+	};
+
+}
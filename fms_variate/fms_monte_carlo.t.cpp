@@ -0,0 +1,192 @@
+// fms_monte_carlo.t.cpp - test reproducible Monte Carlo
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <thread>
+#include "fms_test.h"
+#include "fms_monte_carlo.h"
+#include "fms_variate_logistic.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+int test_parallel_for_each()
+{
+	std::vector<size_t> x(1000);
+	parallel::for_each(x.size(), [&x](size_t i) { x[i] = i * i; }, 4);
+	for (size_t i = 0; i < x.size(); ++i) {
+		assert(x[i] == i * i);
+	}
+
+	bool thrown = false;
+	try {
+		parallel::for_each(100, [](size_t i) { ensure(i != 17); }, 3);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	assert(thrown);
+
+	return 0;
+}
+int test_parallel_for_each_ = test_parallel_for_each();
+
+template<class X>
+int test_monte_carlo()
+{
+	constexpr size_t paths = 1'000'003; // last chunk is partial
+	auto id = [](X x) { return x; };
+	auto call = [](X x) { return std::max(x - X(0.5), X(0)); };
+
+	{
+		standard_normal<X> N;
+		X s = X(0.2);
+		auto m = monte_carlo<X>(1234, 1 << 12, 1)(N, paths, s, id, call);
+
+		// identical for any number of threads
+		for (unsigned t : {2u, 3u, 8u}) {
+			auto m_ = monte_carlo<X>(1234, 1 << 12, t)(N, paths, s, id, call);
+			for (size_t k = 0; k < 2; ++k) {
+				assert(m[k].n == paths and m_[k].n == paths);
+				assert(m[k].mean == m_[k].mean and m[k].m2 == m_[k].m2);
+			}
+		}
+
+		assert(fabs(m[0].mean - s) < 5 * m[0].error());
+		assert(fabs(m[0].variance() - 1) < 5 * sqrt(X(2) / paths));
+		// E[(X - k)^+] = phi(k - s) - (k - s)(1 - Phi(k - s)) for X normal with mean s
+		X k_ = X(0.5) - s;
+		X c = N.cdf(k_, 0, 1) - k_ * (1 - N.cdf(k_));
+		assert(fabs(m[1].mean - c) < 5 * m[1].error());
+		assert(fabs(m[1].second() - (m[1].variance() * (paths - 1) / paths + c * c)) < 1e-3);
+	}
+	{
+		logistic<X> L(2, 1.5);
+		X s = X(-0.4);
+		auto m = monte_carlo<X>(99)(L, paths, s, id);
+		assert(fabs(m[0].mean - L.cumulant(s, 1)) < 5 * m[0].error());
+		assert(fabs(m[0].variance() - L.cumulant(s, 2)) < X(0.02) * L.cumulant(s, 2));
+	}
+
+	return 0;
+}
+int test_monte_carlo_d = test_monte_carlo<double>();
+
+template<class X>
+int test_quasi_monte_carlo()
+{
+	auto call = [](X x) { return std::max(x - X(0.5), X(0)); };
+	auto square = [](X x) { return x * x; };
+	{
+		standard_normal<X> N;
+		X s = X(0.2);
+		X k_ = X(0.5) - s;
+		X c = N.cdf(k_, 0, 1) - k_ * (1 - N.cdf(k_));
+
+		constexpr size_t points = 1 << 14;
+		auto q = quasi_monte_carlo<X>(5, 16, 1 << 12, 1)(N, points, s, call, square);
+		assert(q[0].n == 16);
+		assert(fabs(q[0].mean - c) < 5 * q[0].error());
+		assert(fabs(q[1].mean - (1 + s * s)) < 5 * q[1].error());
+
+		// identical for any number of threads
+		auto q_ = quasi_monte_carlo<X>(5, 16, 1 << 12, 3)(N, points, s, call, square);
+		assert(q[0].mean == q_[0].mean and q[0].m2 == q_[0].m2);
+
+		// much smaller error than Monte Carlo with the same number of draws
+		auto m = monte_carlo<X>(5)(N, 16 * points, s, call, square);
+		assert(q[0].error() < m[0].error() / 10);
+		assert(q[1].error() < m[1].error() / 10);
+
+		// error decreases faster than 1/sqrt(N)
+		auto q4 = quasi_monte_carlo<X>(5, 16)(N, points / 16, s, square);
+		assert(q[1].error() < q4[0].error() / 6);
+	}
+	{
+		logistic<X> L(2, 1.5);
+		X s = X(-0.4);
+		auto q = quasi_monte_carlo<X>(11, 8)(L, 1 << 10, s, [](X x) { return x; });
+		assert(fabs(q[0].mean - L.cumulant(s, 1)) < 5 * q[0].error());
+		assert(q[0].error() < 1e-3);
+	}
+
+	return 0;
+}
+int test_quasi_monte_carlo_d = test_quasi_monte_carlo<double>();
+
+template<class X>
+int test_importance_sampling()
+{
+	constexpr size_t paths = 100'000;
+	{
+		standard_normal<X> N;
+		for (X x : { X(1), X(4), X(8) }) {
+			auto t = importance_sampling<X>(3)(N, x, paths);
+			X p = std::erfc(x * X(0.70710678118654752440)) / 2;
+			X es = std::exp(-x * x / 2) / std::sqrt(2 * X(3.14159265358979323846)) / p;
+			assert(t.s == x and t.n == paths);
+			assert(fabs(t.probability - p) < 5 * t.probability_error);
+			assert(fabs(t.shortfall - es) < 5 * t.shortfall_error);
+			// relative error instead of 1/sqrt(n p)
+			assert(t.probability_error < X(0.02) * p);
+			if (x > 1) {
+				assert(t.probability_error < sqrt(p / paths) / 50);
+			}
+		}
+
+		// identical for any number of threads
+		auto t1 = importance_sampling<X>(3, 1 << 12, 1)(N, X(4), paths);
+		auto t3 = importance_sampling<X>(3, 1 << 12, 3)(N, X(4), paths);
+		assert(t1.probability == t3.probability and t1.shortfall_error == t3.shortfall_error);
+
+		// below the mean is plain Monte Carlo
+		auto t = importance_sampling<X>(3)(N, X(-1), paths, X(0.5));
+		assert(t.s == X(0.5));
+		assert(fabs(t.probability - std::erfc(X(-1.5) * X(0.70710678118654752440)) / 2) < 5 * t.probability_error);
+	}
+	{
+		logistic<X> L(2, 1.5);
+		logistic<X> R(1.5, 2); // -X
+		auto P = [&R](X u) { return R.cdf(-u, 0, 0); }; // P(X > u)
+		for (X x : { X(2), X(10), X(25) }) {
+			auto t = importance_sampling<X>(5)(L, x, paths);
+			X p = P(x);
+			assert(fabs(L.cumulant(t.s, 1) - x) < 1e-12 * x);
+			assert(fabs(t.probability - p) < 5 * t.probability_error);
+			assert(t.probability_error < X(0.03) * p);
+			// E[X | X > x] = x + int_x^infty P(X > u) du/P(X > x) using Simpson's rule
+			X h = X(0.01), I = 0;
+			int m = 6000;
+			for (int i = 0; i <= m; ++i) {
+				I += (i == 0 or i == m ? 1 : (i & 1) ? 4 : 2) * P(x + i * h);
+			}
+			X es = x + I * h / 3 / p;
+			assert(fabs(t.shortfall - es) < 5 * t.shortfall_error);
+		}
+	}
+
+	return 0;
+}
+int test_importance_sampling_d = test_importance_sampling<double>();
+
+// paths per second on one thread and on all threads, and scaling efficiency
+template<class X>
+int benchmark_monte_carlo()
+{
+	constexpr size_t paths = 1 << 23;
+	standard_normal<X> N;
+	auto call = [](X x) { return std::max(x - X(0.5), X(0)); };
+	unsigned T = parallel::threads();
+
+	double ms_1 = test::best(3, [&]() { monte_carlo<X>(1, 1 << 14, 1)(N, paths, X(0), call); });
+	double ms_T = test::best(3, [&]() { monte_carlo<X>(1, 1 << 14, T)(N, paths, X(0), call); });
+
+	double paths_per_sec_1 = test::report("monte_carlo paths per sec 1 thread", 1000 * paths / ms_1);
+	double paths_per_sec_T = test::report("monte_carlo paths per sec " + std::to_string(T) + " threads", 1000 * paths / ms_T);
+	double efficiency = test::report("monte_carlo scaling efficiency", paths_per_sec_T / (T * paths_per_sec_1));
+	assert(efficiency > 0);
+
+	return paths_per_sec_T > 0;
+}
+int benchmark_monte_carlo_d = benchmark_monte_carlo<double>();
@@ -0,0 +1,207 @@
+// fms_option.h - European option values on F = f exp(s X - kappa(s))
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_fft.h"
+#include "fms_variate.h"
+
+namespace fms::option {
+
+	// E[(k - F)^+] = k P(F <= k) - f P_s(F <= k) where F <= k if and only if X <= (log(k/f) + kappa(s))/s
+	template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+	inline X put(const V& v, X f, S s, X k)
+	{
+		ensure(f > 0 and s > 0 and k >= 0);
+
+		if (k == 0) {
+			return 0;
+		}
+		X x = X((log(k / f) + v.cumulant(s, 0)) / s);
+
+		return k * v.cdf(x, 0, 0) - f * v.cdf(x, s, 0);
+	}
+
+	// E[(F - k)^+] = E[(k - F)^+] + f - k
+	template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+	inline X call(const V& v, X f, S s, X k)
+	{
+		return put(v, f, s, k) + f - k;
+	}
+
+	static inline const char carr_madan_doc[] = R"xyzyx(
+Value calls at log moneyness \(|k| \le k_{\max}\) using one FFT of the characteristic function of \(Y = \log F/f = sX - \kappa(s)\),
+\(E[e^{iuY}] = \exp(\kappa(isu) - iu\kappa(s))\).
+The damped normalized call \(e^{\alpha k}E[(e^Y - e^k)^+]\) has Fourier transform
+\(\psi(u) = E[e^{i(u - (\alpha + 1)i)Y}]/(\alpha^2 + \alpha - u^2 + i(2\alpha + 1)u)\) and
+\(E[(e^Y - e^k)^+] = e^{-\alpha k}/\pi\int_0^\infty \operatorname{Re} e^{-iuk}\psi(u)\,du\).
+The real part of the integrand is even in \(u\) so the trapezoidal rule is spectrally accurate, unlike
+Simpson's rule used by Carr and Madan. It is discretized at \(u_j = j\eta\), \(0\le j < N\), giving values at log moneyness
+\(k_m = (m - N/2)\lambda\) with \(\lambda\eta = 2\pi/N\), and strikes between these are interpolated using 8 points.
+The damping \(\alpha\) starts at \(\min(16, 10/k_{\max})\) and is halved until \(E[F^{2\alpha + 1}]\) is finite and
+the rounding error \(\epsilon_{\text{machine}}e^{\alpha k_{\max}}\psi(0)\) is below \(e^{-5}\epsilon\).
+The period \(N\lambda\) is \(2k_{\max} + \log((1 + M)/\epsilon)/\alpha\), where \(M = E[e^{(2\alpha + 1)Y}]\),
+so the wrapped values are below \(\epsilon\), plus room for the interpolation points.
+The spacing \(\lambda\) bounds the interpolation error by \(\epsilon\) for a normal density with the standard deviation of \(Y\),
+and \(\psi\) is only evaluated until \(e^{\alpha k_{\max}}|\psi(u_j)|u_j/\pi < \epsilon\), the remaining terms being zero.
+)xyzyx";
+	template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+		requires variate_cumulant_complex_concept<V>
+	class carr_madan {
+		using C = std::complex<X>;
+		static constexpr X pi = X(3.14159265358979323846);
+		static constexpr int P = 8; // interpolation points
+
+		X kmax, k0, dk; // log moneyness k_m = k0 + m dk
+		std::vector<X> c; // E[(e^Y - e^k)^+] at k_m
+
+		// kappa(s) is finite
+		static bool defined(const V& v, S s)
+		{
+			try {
+				return std::isfinite(v.cumulant(s, 0));
+			}
+			catch (const std::runtime_error&) {
+				return false;
+			}
+		}
+		// Fourier transform of the damped call
+		static C psi(const V& v, S s, S ks, X alpha, X u)
+		{
+			// E[exp(i z Y)] at z = u - (alpha + 1)i is exp(kappa(i s z) - i z kappa(s)), written in reals
+			X a = alpha + 1;
+			C phi = exp(v.cumulant(C(s * a, s * u)) - C(a * ks, u * ks));
+			X re = alpha * alpha + alpha - u * u, im = (2 * alpha + 1) * u;
+			X d = re * re + im * im;
+
+			return C((phi.real() * re + phi.imag() * im) / d, (phi.imag() * re - phi.real() * im) / d);
+		}
+	public:
+		// values at log moneyness |k| <= kmax with absolute error about tol, alpha chosen as above if 0
+		carr_madan(const V& v, S s, X kmax, X tol = X(1e-10), X alpha = 0)
+			: kmax(kmax)
+		{
+			static constexpr X eps = std::numeric_limits<X>::epsilon();
+
+			ensure(s > 0);
+			ensure(kmax > 0);
+			ensure(tol > 0);
+
+			S ks = v.cumulant(s, 0);
+			auto logE = [&](X a) { return X(v.cumulant(s * a, 0) - a * ks); }; // log E[e^{aY}]
+			if (alpha == 0) {
+				alpha = std::min(X(16), 10 / kmax);
+				while (!defined(v, s * (2 * alpha + 1))
+					or alpha * kmax + logE(alpha + 1) - log(alpha * (alpha + 1)) > log(tol / eps) - 5) {
+					alpha /= 2;
+					ensure(alpha > X(1e-3));
+				}
+			}
+			ensure(alpha > 0 and defined(v, s * (2 * alpha + 1)));
+
+			// 8 point interpolation error is about 1e-3 dk^8 max |c^(8)| and c^(8) ~ 6 e^k/sigma^7 for a normal density
+			X sigma = X(s * sqrt(v.cumulant(0, 2)));
+			X h = pow(156 * tol * pow(sigma, 7) * exp(-kmax), X(1) / 8);
+			X L = 2 * (kmax + (P / 2 + 1) * h) + log((1 + exp(logE(2 * alpha + 1))) / tol) / alpha;
+			X eta = 2 * pi / L; // u_j = j eta
+			k0 = -L / 2;
+
+			// e^{i b u_j} = (-1)^j for b = -k0 since b eta = pi
+			// terms past where e^{alpha kmax}/pi |psi(u)| u is below tol are zero
+			std::vector<C> a_;
+			X a = exp(alpha * kmax) / pi;
+			for (size_t j = 0; ; ++j) {
+				X u = X(j) * eta;
+				C p = psi(v, s, ks, alpha, u);
+				a_.push_back(p * (j == 0 ? eta / 2 : (j & 1) ? -eta : eta));
+				if (j > 0 and a * abs(p) * u < tol) {
+					break;
+				}
+				ensure(j < (size_t(1) << 24)); // characteristic function decays
+			}
+			size_t N = std::max({ fft::pow2(static_cast<size_t>(L / h) + 1), fft::pow2(a_.size()), size_t(2 * P) });
+			a_.resize(N);
+			dk = L / X(N);
+
+			fft::transform<X>(a_);
+			c.resize(N);
+			X e = exp(-alpha * k0) / pi, de = exp(-alpha * dk);
+			for (size_t m = 0; m < N; ++m) {
+				c[m] = e * a_[m].real();
+				e *= de;
+			}
+		}
+
+		// number of points in the grid
+		size_t size() const
+		{
+			return c.size();
+		}
+
+		// E[(e^Y - e^k)^+] interpolated at log moneyness k
+		X value(X k) const
+		{
+			// Lagrange weights 1/prod_{i != j} (j - i) for nodes m - 3, ..., m + 4
+			static constexpr X w[P] = { -1, 7, -21, 35, -35, 21, -7, 1 };
+
+			ensure(fabs(k) <= kmax);
+			X t = (k - k0) / dk;
+			size_t m = static_cast<size_t>(t);
+			ensure(m >= P / 2 - 1 and m + P / 2 < c.size());
+			t -= X(m) - (P / 2 - 1); // nodes at 0, ..., P - 1
+			const X* cm = &c[m - (P / 2 - 1)];
+
+			// sum_j w_j c_j prod_{i != j} (t - i) using prefix and suffix products
+			X l[P];
+			X p = 1;
+			for (int j = 0; j < P; ++j) {
+				l[j] = p;
+				p *= t - X(j);
+			}
+			X v = 0;
+			p = 1;
+			for (int j = P - 1; j >= 0; --j) {
+				v += w[j] * l[j] * p * cm[j];
+				p *= t - X(j);
+			}
+
+			return v / 5040; // 7!
+		}
+
+		X call(X f, X k) const
+		{
+			ensure(f > 0 and k > 0);
+
+			return f * value(log(k / f));
+		}
+		X put(X f, X k) const
+		{
+			return call(f, k) - f + k;
+		}
+
+		// out[i] = call(f, k[i]), k and out may alias
+		void call(X f, std::span<const X> k, std::span<X> out) const
+		{
+			ensure(out.size() >= k.size());
+
+			for (size_t i = 0; i < k.size(); ++i) {
+				out[i] = call(f, k[i]);
+			}
+		}
+		// out[i] = put(f, k[i]), k and out may alias
+		void put(X f, std::span<const X> k, std::span<X> out) const
+		{
+			ensure(out.size() >= k.size());
+
+			for (size_t i = 0; i < k.size(); ++i) {
+				out[i] = put(f, k[i]);
+			}
+		}
+	};
+
+}
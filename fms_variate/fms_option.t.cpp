@@ -0,0 +1,141 @@
+// fms_option.t.cpp - test option values
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "fms_test.h"
+#include "fms_option.h"
+#include "fms_variate_logistic.h"
+#include "fms_variate_normal.h"
+#include "fms_variate_sum.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_cumulant_complex_concept<standard_normal<>>);
+static_assert(variate_cumulant_complex_concept<logistic<>>);
+static_assert(variate_cumulant_complex_concept<sum<standard_normal<>, logistic<>>>);
+
+template<class X>
+int test_variate_characteristic()
+{
+	using C = std::complex<X>;
+	standard_normal<X> N;
+	logistic<X> L(X(1.5), 2);
+	X s = X(0.3);
+
+	for (X u : { X(0), X(0.5), X(1), X(4) }) {
+		// E_s[exp(iuX)] = exp(ius - u^2/2) for X_s normal with mean s
+		C phi = characteristic(N, u, s);
+		assert(abs(phi - exp(C(-u * u / 2, u * s))) < 1e-15);
+
+		// real axis agrees with the cumulant
+		X t = u / 2 - 1;
+		assert(fabs(L.cumulant(C(t, 0)).real() - L.cumulant(t, 0)) < 1e-13);
+		assert(fabs(L.cumulant(C(t, 0)).imag()) < 1e-15);
+
+		// mu + sigma X and sums
+		affine A(L, X(0.5), X(2));
+		C z(s, u);
+		assert(abs(A.cumulant(z) - (X(0.5) * z + L.cumulant(X(2) * z))) < 1e-14);
+		sum<standard_normal<X>, logistic<X>> S(N, L);
+		assert(abs(S.cumulant(z) - (N.cumulant(z) + L.cumulant(z))) < 1e-14);
+	}
+	// |phi(u)| <= 1 and phi(-u) = conj(phi(u))
+	for (X u = -8; u <= 8; u += X(0.25)) {
+		C phi = characteristic(L, u, s);
+		assert(abs(phi) <= 1 + 1e-14);
+		assert(abs(characteristic(L, -u, s) - conj(phi)) < 1e-14);
+	}
+
+	return 0;
+}
+int test_variate_characteristic_d = test_variate_characteristic<double>();
+
+template<class X>
+int test_option_carr_madan()
+{
+	standard_normal<X> N;
+	logistic<X> L(X(1.5), 2);
+	X f = 100;
+
+	std::vector<X> k;
+	for (X k_ = 25; k_ <= 400; k_ *= X(1.01)) {
+		k.push_back(k_);
+	}
+	std::vector<X> p(k.size()), c(k.size());
+	X kmax = log(X(4)); // 25 to 400
+
+	for (X s : { X(0.05), X(0.2), X(1) }) {
+		{
+			// Black put k N(-d2) - f N(-d1)
+			option::carr_madan cm(N, s, kmax);
+			cm.put(f, k, p);
+			cm.call(f, k, c);
+			for (size_t i = 0; i < k.size(); ++i) {
+				X d2 = (log(f / k[i]) - s * s / 2) / s;
+				X d1 = d2 + s;
+				X put = k[i] * erfc(d2 * X(0.70710678118654752440)) / 2 - f * erfc(d1 * X(0.70710678118654752440)) / 2;
+				assert(fabs(option::put(N, f, s, k[i]) - put) < 1e-12 * f);
+				assert(fabs(p[i] - put) < 1e-9 * f);
+				assert(fabs(c[i] - p[i] - (f - k[i])) < 1e-12 * f);
+			}
+		}
+		{
+			// s = 1 is close to the largest moment of F
+			option::carr_madan cm(L, s, kmax);
+			cm.put(f, k, p);
+			for (size_t i = 0; i < k.size(); ++i) {
+				assert(fabs(p[i] - option::put(L, f, s, k[i])) < 1e-9 * f);
+			}
+		}
+	}
+	{
+		sum<standard_normal<X>, logistic<X>> S(N, L);
+		X s = X(0.2);
+		option::carr_madan cm(S, s, log(X(2)));
+		for (X k_ : { X(50), X(90), X(100), X(110), X(200) }) {
+			assert(fabs(cm.put(f, k_) - option::put(S, f, s, k_)) < 1e-8 * f);
+		}
+	}
+
+	return 0;
+}
+int test_option_carr_madan_d = test_option_carr_madan<double>();
+
+// tens of terms per strike versus two cdf evaluations per strike
+template<class V, class X = typename V::xtype>
+double benchmark_option_carr_madan(const V& v)
+{
+	X f = 100, s = X(0.2);
+	constexpr size_t n = 512;
+	std::vector<X> k(n), p(n), q(n);
+	for (size_t i = 0; i < n; ++i) {
+		k[i] = 50 + 100 * X(i) / n;
+	}
+	X kmax = log(X(2));
+
+	double ms_cm = test::best(8, [&]() { option::carr_madan(v, s, kmax).put(f, k, p); });
+	double ms_cdf = test::best(8, [&]() {
+		for (size_t i = 0; i < n; ++i) {
+			q[i] = option::put(v, f, s, k[i]);
+		}
+	});
+	for (size_t i = 0; i < n; ++i) {
+		assert(fabs(p[i] - q[i]) < 1e-8 * f);
+	}
+
+	return ms_cm / ms_cdf;
+}
+int benchmark_option_carr_madan_d()
+{
+	// the logistic cdf is an incomplete beta function, one FFT costs a handful of them
+	double r = test::report("carr_madan/put logistic 512 strikes", benchmark_option_carr_madan(logistic<>(1.5, 2)));
+	assert(r < 0.1);
+	// the normal cdf is erfc, about the cost of interpolating
+	r = test::report("carr_madan/put normal 512 strikes", benchmark_option_carr_madan(standard_normal<>{}));
+	assert(r < 2);
+
+	return 0;
+}
+int benchmark_option_carr_madan_ = benchmark_option_carr_madan_d();
@@ -0,0 +1,58 @@
+// fms_parallel.h - run indexed tasks on a pool of threads
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fms::parallel {
+
+	// number of threads to use when 0 is requested
+	inline unsigned threads(unsigned n = 0)
+	{
+		return n ? n : std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Call f(i) for 0 <= i < n using up to n_threads threads including the caller.
+	// Idle threads take the next index from a shared counter so uneven tasks balance.
+	// The first exception thrown by f is rethrown after all threads finish.
+	template<class F>
+	inline void for_each(size_t n, const F& f, unsigned n_threads = 0)
+	{
+		std::atomic<size_t> next = 0;
+		std::exception_ptr ex;
+		std::mutex m;
+
+		auto work = [&]() {
+			for (size_t i; (i = next.fetch_add(1)) < n; ) {
+				try {
+					f(i);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(m);
+					if (!ex) {
+						ex = std::current_exception();
+					}
+					next = n; // stop handing out work
+				}
+			}
+		};
+
+		unsigned t = static_cast<unsigned>(std::min<size_t>(threads(n_threads), n));
+		std::vector<std::thread> pool;
+		for (unsigned j = 1; j < t; ++j) {
+			pool.emplace_back(work);
+		}
+		work();
+		for (auto& th : pool) {
+			th.join();
+		}
+
+		if (ex) {
+			std::rethrow_exception(ex);
+		}
+	}
+
+}
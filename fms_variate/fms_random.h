@@ -0,0 +1,220 @@
+// fms_random.h - counter based generator and uniform, normal, and gamma draws
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+
+namespace fms::random {
+
+	// 64 random bits from generators producing 32 or 64 bits per call
+	template<std::uniform_random_bit_generator R>
+	inline uint64_t bits(R& r)
+	{
+		using T = typename R::result_type;
+		constexpr uint64_t range = static_cast<uint64_t>(R::max() - R::min());
+
+		if constexpr (range == std::numeric_limits<uint64_t>::max()) {
+			return static_cast<uint64_t>(r() - R::min());
+		}
+		else {
+			static_assert(range == std::numeric_limits<uint32_t>::max(), "generator must produce 32 or 64 bits");
+			uint64_t hi = static_cast<uint64_t>(static_cast<T>(r() - R::min()));
+
+			return (hi << 32) | static_cast<uint64_t>(static_cast<T>(r() - R::min()));
+		}
+	}
+
+	// Counter based Philox4x32-10 generator of Salmon, Moraes, Dror, and Shaw.
+	// The 64 bit key is the seed, the high half of the 128 bit counter selects the stream,
+	// and the low half counts blocks of four 32 bit outputs returned as two 64 bit values.
+	// Streams with different (seed, stream) are independent and can be created anywhere.
+	class philox {
+		uint32_t k[2];
+		uint32_t c[4];
+		uint64_t out[2];
+		int i; // next output in out
+
+		static void round(uint32_t (&x)[4], const uint32_t (&k)[2])
+		{
+			uint64_t p0 = uint64_t(0xD2511F53) * x[0];
+			uint64_t p1 = uint64_t(0xCD9E8D57) * x[2];
+			uint32_t y[4] = {
+				uint32_t(p1 >> 32) ^ x[1] ^ k[0], uint32_t(p1),
+				uint32_t(p0 >> 32) ^ x[3] ^ k[1], uint32_t(p0)
+			};
+			x[0] = y[0]; x[1] = y[1]; x[2] = y[2]; x[3] = y[3];
+		}
+	public:
+		using result_type = uint64_t;
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+		philox(uint64_t seed = 0, uint64_t stream = 0)
+			: k{ uint32_t(seed), uint32_t(seed >> 32) }, c{ 0, 0, uint32_t(stream), uint32_t(stream >> 32) }, out{ 0, 0 }, i(2)
+		{ }
+
+		// ten rounds on counter x with key k
+		static void block(uint32_t (&x)[4], const uint32_t (&key)[2])
+		{
+			uint32_t k_[2] = { key[0], key[1] };
+			for (int r = 0; r < 10; ++r) {
+				if (r) {
+					k_[0] += 0x9E3779B9;
+					k_[1] += 0xBB67AE85;
+				}
+				round(x, k_);
+			}
+		}
+
+		result_type operator()()
+		{
+			if (i == 2) {
+				uint32_t x[4] = { c[0], c[1], c[2], c[3] };
+				block(x, k);
+				out[0] = (uint64_t(x[1]) << 32) | x[0];
+				out[1] = (uint64_t(x[3]) << 32) | x[2];
+				i = 0;
+				if (++c[0] == 0) {
+					++c[1];
+				}
+			}
+
+			return out[i++];
+		}
+
+		// skip n outputs
+		void discard(uint64_t n)
+		{
+			while (n and i < 2) {
+				++i;
+				--n;
+			}
+			uint64_t b = ((uint64_t(c[1]) << 32) | c[0]) + n / 2;
+			c[0] = uint32_t(b);
+			c[1] = uint32_t(b >> 32);
+			if (n % 2) {
+				operator()();
+			}
+		}
+	};
+
+	// (k + 1/2) 2^-52 from the top 52 bits, exact and never 0 or 1
+	inline double uniform(uint64_t u)
+	{
+		return (static_cast<double>(u >> 12) + 0.5) * 0x1p-52;
+	}
+	template<std::uniform_random_bit_generator R>
+	inline double uniform(R& r)
+	{
+		return uniform(bits(r));
+	}
+
+	// Standard normal using Doornik's ZIGNOR ziggurat with 128 layers.
+	// One 64 bit draw supplies the layer (low 7 bits) and the uniform (top 52 bits).
+	class ziggurat {
+		static constexpr int C = 128;
+		static constexpr double R_ = 3.442619855899;
+		static constexpr double V = 9.91256303526217e-3; // area of each layer
+		double x[C + 1];
+		double r[C]; // x[i + 1]/x[i]
+
+		ziggurat()
+		{
+			double f = exp(-0.5 * R_ * R_);
+			x[0] = V / f;
+			x[1] = R_;
+			x[C] = 0;
+			for (int i = 2; i < C; ++i) {
+				x[i] = sqrt(-2 * log(V / x[i - 1] + f));
+				f = exp(-0.5 * x[i] * x[i]);
+			}
+			for (int i = 0; i < C; ++i) {
+				r[i] = x[i + 1] / x[i];
+			}
+		}
+
+		// x > R_ with density proportional to phi
+		template<class G>
+		double tail(G& g, bool negative) const
+		{
+			double x_, y;
+			do {
+				x_ = log(uniform(g)) / R_;
+				y = log(uniform(g));
+			} while (-2 * y < x_ * x_);
+
+			return negative ? x_ - R_ : R_ - x_;
+		}
+	public:
+		static const ziggurat& table()
+		{
+			static const ziggurat z;
+
+			return z;
+		}
+
+		template<std::uniform_random_bit_generator G>
+		double operator()(G& g) const
+		{
+			for (;;) {
+				uint64_t b = bits(g);
+				double u = 2 * uniform(b) - 1;
+				int i = static_cast<int>(b & (C - 1));
+
+				if (fabs(u) < r[i]) {
+					return u * x[i];
+				}
+				if (i == 0) {
+					return tail(g, u < 0);
+				}
+				double x_ = u * x[i];
+				double f0 = exp(-0.5 * (x[i] * x[i] - x_ * x_));
+				double f1 = exp(-0.5 * (x[i + 1] * x[i + 1] - x_ * x_));
+				if (f1 + uniform(g) * (f0 - f1) < 1) {
+					return x_;
+				}
+			}
+		}
+	};
+
+	template<std::uniform_random_bit_generator G>
+	inline double normal(G& g)
+	{
+		return ziggurat::table()(g);
+	}
+
+	// log of a Gamma(a, 1) draw using Marsaglia and Tsang for a >= 1 and
+	// log G_a = log G_{a + 1} + log(U)/a for a < 1 so small shapes do not underflow.
+	class log_gamma {
+		double a, d, c;
+	public:
+		log_gamma(double a)
+			: a(a), d((a < 1 ? a + 1 : a) - 1. / 3), c(1 / sqrt(9 * d))
+		{ }
+
+		template<std::uniform_random_bit_generator G>
+		double operator()(G& g) const
+		{
+			double v;
+			for (;;) {
+				double x = normal(g);
+				v = 1 + c * x;
+				if (v <= 0) {
+					continue;
+				}
+				v = v * v * v;
+				double u = uniform(g);
+				double x2 = x * x;
+				if (u < 1 - 0.0331 * x2 * x2 or log(u) < 0.5 * x2 + d * (1 - v + log(v))) {
+					break;
+				}
+			}
+			double lg = log(d) + log(v);
+
+			return a < 1 ? lg + log(uniform(g)) / a : lg;
+		}
+	};
+
+}
@@ -0,0 +1,113 @@
+// fms_random.t.cpp - test uniform, normal, and gamma draws
+#include <cassert>
+#include <random>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+
+using namespace fms;
+
+// mean and variance of n draws
+template<class F>
+inline std::pair<double, double> moments(F f, size_t n)
+{
+	double m = 0, m2 = 0;
+
+	for (size_t i = 1; i <= n; ++i) {
+		double x = f();
+		double dx = x - m;
+		m += dx / i;
+		m2 += dx * (x - m);
+	}
+
+	return { m, m2 / (n - 1) };
+}
+
+// known answers from the Random123 distribution
+int test_random_philox()
+{
+	{
+		uint32_t x[4] = { 0, 0, 0, 0 };
+		uint32_t k[2] = { 0, 0 };
+		random::philox::block(x, k);
+		assert(x[0] == 0x6627e8d5 and x[1] == 0xe169c58d and x[2] == 0xbc57ac4c and x[3] == 0x9b00dbd8);
+	}
+	{
+		uint32_t x[4] = { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 };
+		uint32_t k[2] = { 0xa4093822, 0x299f31d0 };
+		random::philox::block(x, k);
+		assert(x[0] == 0xd16cfe09 and x[1] == 0x94fdcceb and x[2] == 0x5001e420 and x[3] == 0x24126ea1);
+	}
+	{
+		random::philox g(5, 7), h(5, 7), g_(5, 8);
+		h.discard(5);
+		for (int i = 0; i < 5; ++i) {
+			g();
+		}
+		assert(g() == h() and g() == h());
+		assert(g() != g_());
+	}
+
+	return 0;
+}
+int test_random_philox_ = test_random_philox();
+
+int test_random()
+{
+	constexpr size_t n = 200'000;
+	double se = 5 / sqrt(double(n)); // five standard errors per unit standard deviation
+	std::mt19937_64 r64(123);
+	std::mt19937 r32(123);
+
+	{
+		auto [m, v] = moments([&]() { return random::uniform(r64); }, n);
+		assert(fabs(m - 0.5) < se * sqrt(1. / 12));
+		assert(fabs(v - 1. / 12) < se * sqrt(1. / 180)); // var of (U - 1/2)^2 is 1/180
+		auto [m_, v_] = moments([&]() { return random::uniform(r32); }, n);
+		assert(fabs(m_ - 0.5) < se * sqrt(1. / 12));
+		assert(random::uniform(uint64_t(0)) > 0 and random::uniform(~uint64_t(0)) < 1);
+	}
+	{
+		size_t tail = 0;
+		auto [m, v] = moments([&]() { double x = random::normal(r64); tail += fabs(x) > 3.442619855899; return x; }, n);
+		assert(fabs(m) < se);
+		assert(fabs(v - 1) < se * sqrt(2.));
+		// P(|X| > R) = 5.76e-4
+		assert(fabs(tail - 5.76e-4 * n) < 5 * sqrt(5.76e-4 * n));
+	}
+	for (double a : {0.3, 1., 2.5, 40.}) {
+		random::log_gamma G(a);
+		auto [m, v] = moments([&]() { return exp(G(r64)); }, n);
+		assert(fabs(m - a) < se * sqrt(a));
+		assert(fabs(v - a) < se * sqrt(2 * a * a + 6 * a)); // var of (G - a)^2 is 2a^2 + 6a
+	}
+
+	return 0;
+}
+int test_random_ = test_random();
+
+// draws per second for the ziggurat and std::normal_distribution
+int benchmark_random_normal()
+{
+	constexpr size_t n = 1'000'000;
+	std::mt19937_64 r(0);
+	std::normal_distribution<double> N;
+	double sum = 0;
+
+	double ms = test::best(5, [&]() {
+		for (size_t i = 0; i < n; ++i) {
+			sum += random::normal(r);
+		}
+	});
+	double ms_std = test::best(5, [&]() {
+		for (size_t i = 0; i < n; ++i) {
+			sum += N(r);
+		}
+	});
+	double per_sec = test::report("ziggurat normal per sec", 1000 * n / ms);
+	double per_sec_std = test::report("std::normal_distribution per sec", 1000 * n / ms_std);
+	assert(per_sec > per_sec_std / 2); // not horrible
+
+	return sum != 0;
+}
+int benchmark_random_normal_ = benchmark_random_normal();
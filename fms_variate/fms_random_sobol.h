@@ -0,0 +1,199 @@
+// fms_random_sobol.h - scrambled Sobol low discrepancy sequence
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_random.h"
+
+namespace fms::random {
+
+	// Sobol points in [0,1)^d using the Joe and Kuo (2008) direction numbers and Gray code order.
+	// The first 2^m points of each dimension have exactly one point in each interval [k 2^-m, (k + 1) 2^-m).
+	// Scrambling randomizes the points while keeping this so averages over independent
+	// scrambles give unbiased estimates and an error estimate (randomized quasi Monte Carlo).
+	// Points are (x + 1/2) 2^-32 for 32 bit integers x so they are never 0 or 1.
+	class sobol {
+	public:
+		enum class scramble {
+			none,
+			digital, // xor with a random shift in each dimension
+			owen, // nested uniform scramble using the hash of Laine, Karras, and Burley
+		};
+		static constexpr unsigned max_dimension = 21;
+	private:
+		// degree s, polynomial coefficients a, and initial direction numbers m of dimensions 2 to max_dimension
+		struct direction {
+			unsigned s, a, m[7];
+		};
+		static constexpr direction joe_kuo[max_dimension - 1] = {
+			{ 1, 0, { 1 } },
+			{ 2, 1, { 1, 3 } },
+			{ 3, 1, { 1, 3, 1 } },
+			{ 3, 2, { 1, 1, 1 } },
+			{ 4, 1, { 1, 1, 3, 3 } },
+			{ 4, 4, { 1, 3, 5, 13 } },
+			{ 5, 2, { 1, 1, 5, 5, 17 } },
+			{ 5, 4, { 1, 1, 5, 5, 5 } },
+			{ 5, 7, { 1, 1, 7, 11, 19 } },
+			{ 5, 11, { 1, 1, 5, 1, 1 } },
+			{ 5, 13, { 1, 1, 1, 3, 11 } },
+			{ 5, 14, { 1, 3, 5, 5, 31 } },
+			{ 6, 1, { 1, 3, 3, 9, 7, 49 } },
+			{ 6, 13, { 1, 1, 1, 15, 21, 21 } },
+			{ 6, 16, { 1, 3, 1, 13, 27, 49 } },
+			{ 6, 19, { 1, 1, 1, 15, 7, 5 } },
+			{ 6, 22, { 1, 3, 1, 15, 13, 25 } },
+			{ 6, 25, { 1, 1, 5, 5, 19, 61 } },
+			{ 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+			{ 7, 4, { 1, 3, 7, 13, 13, 15, 69 } },
+		};
+
+		unsigned d;
+		scramble s_;
+		std::vector<uint32_t> v; // v[32 j + k] is direction number k of dimension j
+		std::vector<uint32_t> seed; // scramble of each dimension
+		std::vector<uint32_t> x; // unscrambled point i
+		uint64_t i; // index of next point
+
+		static uint32_t reverse(uint32_t x)
+		{
+			x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+			x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+			x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+			x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+
+			return (x >> 16) | (x << 16);
+		}
+		// position of lowest zero bit
+		static unsigned lowest_zero(uint64_t i)
+		{
+			unsigned c = 0;
+			while (i & 1) {
+				i >>= 1;
+				++c;
+			}
+
+			return c;
+		}
+		// random permutation of x where each bit depends only on higher bits
+		static uint32_t owen(uint32_t x, uint32_t seed)
+		{
+			x = reverse(x);
+			x += seed;
+			x ^= x * 0x6c50b47cu;
+			x ^= x * 0xb82f1e52u;
+			x ^= x * 0xc7afe638u;
+			x ^= x * 0x8d22f6e6u;
+
+			return reverse(x);
+		}
+		double scrambled(unsigned j) const
+		{
+			uint32_t x_ = x[j];
+			if (s_ == scramble::digital) {
+				x_ ^= seed[j];
+			}
+			else if (s_ == scramble::owen) {
+				x_ = owen(x_, seed[j]);
+			}
+
+			return (x_ + 0.5) * 0x1p-32;
+		}
+		void next()
+		{
+			ensure(i < (uint64_t(1) << 32));
+			unsigned c = lowest_zero(i);
+			if (c < 32) { // point 2^32 - 1 is the last
+				const uint32_t* vc = v.data() + c;
+				for (unsigned j = 0; j < d; ++j, vc += 32) {
+					x[j] ^= *vc;
+				}
+			}
+			++i;
+		}
+	public:
+		sobol(unsigned d = 1, scramble s = scramble::owen, uint64_t seed_ = 0)
+			: d(d), s_(s), v(32 * d), seed(d), x(d, 0), i(0)
+		{
+			ensure(1 <= d and d <= max_dimension);
+
+			for (unsigned k = 0; k < 32; ++k) {
+				v[k] = uint32_t(1) << (31 - k);
+			}
+			for (unsigned j = 1; j < d; ++j) {
+				const direction& dj = joe_kuo[j - 1];
+				uint32_t* vj = v.data() + 32 * j;
+				for (unsigned k = 0; k < dj.s; ++k) {
+					vj[k] = dj.m[k] << (31 - k);
+				}
+				for (unsigned k = dj.s; k < 32; ++k) {
+					vj[k] = vj[k - dj.s] ^ (vj[k - dj.s] >> dj.s);
+					for (unsigned l = 1; l < dj.s; ++l) {
+						if ((dj.a >> (dj.s - 1 - l)) & 1) {
+							vj[k] ^= vj[k - l];
+						}
+					}
+				}
+			}
+
+			philox g(seed_, 0x736f626f6cu); // stream reserved for Sobol scrambles
+			for (unsigned j = 0; j < d; ++j) {
+				seed[j] = uint32_t(g());
+			}
+		}
+
+		unsigned dimension() const
+		{
+			return d;
+		}
+		// index of the next point
+		uint64_t index() const
+		{
+			return i;
+		}
+		// next point is point n
+		sobol& skip(uint64_t n)
+		{
+			ensure(n <= (uint64_t(1) << 32));
+			uint64_t g = n ^ (n >> 1); // Gray code of n
+			for (unsigned j = 0; j < d; ++j) {
+				x[j] = 0;
+				for (unsigned k = 0; k < 32; ++k) {
+					if ((g >> k) & 1) {
+						x[j] ^= v[32 * j + k];
+					}
+				}
+			}
+			i = n;
+
+			return *this;
+		}
+
+		// next point in u[0], ..., u[d - 1]
+		void operator()(std::span<double> u)
+		{
+			ensure(u.size() >= d);
+			ensure(i < (uint64_t(1) << 32));
+
+			for (unsigned j = 0; j < d; ++j) {
+				u[j] = scrambled(j);
+			}
+			next();
+		}
+		// next n points with dimension j in out[j n], ..., out[j n + n - 1]
+		void operator()(size_t n, std::span<double> out)
+		{
+			ensure(out.size() >= n * d);
+			ensure(n <= (uint64_t(1) << 32) - i);
+
+			for (size_t k = 0; k < n; ++k) {
+				for (unsigned j = 0; j < d; ++j) {
+					out[j * n + k] = scrambled(j);
+				}
+				next();
+			}
+		}
+	};
+
+}
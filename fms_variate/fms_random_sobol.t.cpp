@@ -0,0 +1,120 @@
+// fms_random_sobol.t.cpp - test scrambled Sobol sequence
+#include <cassert>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random_sobol.h"
+
+using namespace fms;
+using random::sobol;
+
+// number of the first 2^m points of dimensions i and j in each box of size 2^-k by 2^-(m - k)
+inline bool is_net(const std::vector<double>& u, size_t n, unsigned i, unsigned j, unsigned m)
+{
+	for (unsigned k = 0; k <= m; ++k) {
+		std::vector<int> count(size_t(1) << m, 0);
+		for (size_t p = 0; p < (size_t(1) << m); ++p) {
+			size_t a = size_t(u[i * n + p] * (1 << k));
+			size_t b = size_t(u[j * n + p] * (1 << (m - k)));
+			++count[(a << (m - k)) + b];
+		}
+		for (int c : count) {
+			if (c != 1) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int test_random_sobol()
+{
+	constexpr double h = 0x1p-33; // offset of the midpoint
+	{
+		sobol q(3, sobol::scramble::none);
+		double x0[] = { 0, .5, .75, .25, .375, .875, .625, .125 };
+		double x1[] = { 0, .5, .25, .75, .375, .875, .125, .625 };
+		double x2[] = { 0, .5, .25, .75, .625, .125, .875, .375 };
+		double u[3];
+		for (size_t i = 0; i < 8; ++i) {
+			q(u);
+			assert(u[0] == x0[i] + h);
+			assert(u[1] == x1[i] + h);
+			assert(u[2] == x2[i] + h);
+		}
+		assert(q.index() == 8);
+	}
+	for (auto s : { sobol::scramble::none, sobol::scramble::digital, sobol::scramble::owen }) {
+		constexpr unsigned d = sobol::max_dimension;
+		constexpr unsigned m = 10;
+		constexpr size_t n = size_t(1) << m;
+		std::vector<double> u(n * d);
+		sobol q(d, s, 7);
+		q(n, u);
+
+		// one point in each interval of length 2^-m in every dimension
+		for (unsigned j = 0; j < d; ++j) {
+			std::vector<int> count(n, 0);
+			for (size_t i = 0; i < n; ++i) {
+				assert(0 < u[j * n + i] and u[j * n + i] < 1);
+				++count[size_t(u[j * n + i] * n)];
+			}
+			for (int c : count) {
+				assert(c == 1);
+			}
+		}
+		// first two dimensions are a (0, m, 2)-net
+		assert(is_net(u, n, 0, 1, m));
+
+		// skip and point at a time agree with batch
+		sobol r(d, s, 7);
+		r.skip(n - 5);
+		double v[d];
+		for (size_t i = n - 5; i < n; ++i) {
+			r(v);
+			for (unsigned j = 0; j < d; ++j) {
+				assert(v[j] == u[j * n + i]);
+			}
+		}
+		assert(r.index() == n);
+	}
+	{
+		// different seeds give different scrambles of the same net
+		sobol q(1, sobol::scramble::owen, 1), r(1, sobol::scramble::owen, 2);
+		double u, v;
+		q(std::span<double>(&u, 1));
+		r(std::span<double>(&v, 1));
+		assert(u != v);
+	}
+	{
+		sobol q(2);
+		q.skip((uint64_t(1) << 32) - 1);
+		double u[2];
+		q(u);
+		bool thrown = false;
+		try {
+			q(u);
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	return 0;
+}
+int test_random_sobol_ = test_random_sobol();
+
+// points per second
+int benchmark_random_sobol()
+{
+	constexpr size_t n = 1 << 20;
+	std::vector<double> u(n);
+	sobol q(1);
+
+	double ms = test::time([&]() { q.skip(0)(n, u); });
+	double points_per_sec = 1000 * n / ms;
+
+	return points_per_sec > 0;
+}
+int benchmark_random_sobol_ = benchmark_random_sobol();
@@ -0,0 +1,154 @@
+// fms_sf_beta.h - regularized incomplete beta function for fixed parameters
+#pragma once
+#include <cmath>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <gsl/gsl_sf_gamma.h>
+#include "fms_ensure.h"
+#include "fms_sf_simd.h"
+
+namespace fms::sf {
+
+	// I_u(a, b) = B_u(a, b)/B(a, b) for fixed a and b at many u.
+	// log B(a, b) is computed once. Each lane evaluates the continued fraction for
+	// I_u(a, b) = u^a (1 - u)^b/(a B(a, b)) cf(a, b, u) if u < (a + 1)/(a + b + 2),
+	// otherwise 1 - I_{1 - u}(b, a), and a block of lanes iterates until all have converged.
+	template<class X = double>
+		requires std::is_floating_point_v<X>
+	class beta_inc {
+		X a, b;
+		X lnB; // log B(a, b)
+	public:
+		static constexpr int max_iter = 1000;
+
+		beta_inc(X a, X b)
+			: a(a), b(b), lnB(gsl_sf_lnbeta(a, b))
+		{
+			ensure(a > 0 and b > 0);
+		}
+
+		X operator()(X u) const
+		{
+			if constexpr (std::is_same_v<X, double>) {
+				using V = simd::scalar;
+				V u_(u);
+
+				return value(u_, V(1) - u_, V(a) * lane::log(u_) + V(b) * lane::log(V(1) - u_)).v;
+			}
+			else {
+				return gsl_sf_beta_inc(a, b, u);
+			}
+		}
+
+		// out[i] = I_{u[i]}(a, b), u and out may alias
+		void operator()(std::span<const X> u, std::span<X> out) const
+		{
+			ensure(out.size() >= u.size());
+
+			if constexpr (std::is_same_v<X, double>) {
+				simd::transform(u, out, [this](auto u) {
+					using V = decltype(u);
+					V v = V(1) - u;
+					return value(u, v, V(a) * lane::log(u) + V(b) * lane::log(v));
+				});
+			}
+			else {
+				for (size_t i = 0; i < u.size(); ++i) {
+					out[i] = gsl_sf_beta_inc(a, b, u[i]);
+				}
+			}
+		}
+
+		// I_u(a, b) where u = 1/(1 + e^{-x})
+		X logit(X x) const
+		{
+			if constexpr (std::is_same_v<X, double>) {
+				return logit(simd::scalar(x)).v;
+			}
+			else {
+				return gsl_sf_beta_inc(a, b, 1 / (1 + std::exp(-x)));
+			}
+		}
+		// out[i] = I_{u}(a, b) where u = 1/(1 + e^{-x[i]}), x and out may alias
+		void logit(std::span<const X> x, std::span<X> out) const
+		{
+			ensure(out.size() >= x.size());
+
+			if constexpr (std::is_same_v<X, double>) {
+				simd::transform(x, out, [this](auto x) { return logit(x); });
+			}
+			else {
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = logit(x[i]);
+				}
+			}
+		}
+		// u, 1 - u, and their logs are computed from x without cancellation.
+		template<class V>
+			requires (!std::is_same_v<V, X>)
+		V logit(V x) const
+		{
+			V e = lane::exp(-abs(x)); // e^{-|x|}
+			V l = lane::log(V(1) + e);
+			V u0 = V(1) / (V(1) + e);
+			V u1 = e * u0;
+			auto pos = V(0) <= x;
+			// log u = -max(-x, 0) - l, log(1 - u) = -max(x, 0) - l
+			V lnf = V(-a) * (max(-x, V(0)) + l) - V(b) * (max(x, V(0)) + l);
+
+			return value(select(pos, u0, u1), select(pos, u1, u0), lnf);
+		}
+
+		// I_u(a, b) given u, v = 1 - u, and lnf = a log u + b log v
+		template<class V>
+		V value(V u, V v, V lnf) const
+		{
+			auto swap = V((a + 1) / (a + b + 2)) <= u;
+			V p = select(swap, V(b), V(a));
+			V q = select(swap, V(a), V(b));
+			V x = select(swap, v, u);
+			x = select(x <= V(1), x, V(0)); // NaN lanes propagate through lnf
+			V f = lane::exp(lnf - V(lnB)) * cf(p, q, x) / p;
+
+			return select(swap, V(1) - f, f);
+		}
+
+		// continued fraction for B_x(p, q) using the modified Lentz method
+		template<class V>
+		static V cf(V p, V q, V x)
+		{
+			static constexpr double eps = 2 * std::numeric_limits<double>::epsilon();
+			static constexpr double tiny = 1e-300;
+			const V one(1);
+			auto clamp = [](V d) { return select(abs(d) < V(tiny), V(tiny), d); };
+
+			V pq = p + q;
+			V p1 = p + one;
+			V p_1 = p - one;
+			V c = one;
+			V d = one / clamp(one - pq * x / p1);
+			V h = d;
+			for (int m = 1; m <= max_iter; ++m) {
+				V m_(m), m2(2. * m);
+				// even step
+				V a_ = m_ * (q - m_) * x / ((p_1 + m2) * (p + m2));
+				d = one / clamp(one + a_ * d);
+				c = clamp(one + a_ / c);
+				h = h * d * c;
+				// odd step
+				a_ = -(p + m_) * (pq + m_) * x / ((p + m2) * (p1 + m2));
+				d = one / clamp(one + a_ * d);
+				c = clamp(one + a_ / c);
+				V dh = d * c;
+				h = h * dh;
+				if (V::all(abs(dh - one) < V(eps))) {
+					break;
+				}
+			}
+
+			return h;
+		}
+	};
+
+}
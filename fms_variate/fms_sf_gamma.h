@@ -0,0 +1,137 @@
+// fms_sf_gamma.h - log gamma and polygamma functions of all orders, complex log gamma
+#pragma once
+#include <cmath>
+#include <complex>
+#include <span>
+#include <type_traits>
+#include "fms_ensure.h"
+
+namespace fms::sf {
+
+	// B_{2k}, k = 1, ..., 10
+	template<class X>
+	inline constexpr X bernoulli_2k[] = {
+		X(1) / 6, X(-1) / 30, X(1) / 42, X(-1) / 30, X(5) / 66,
+		X(-691) / 2730, X(7) / 6, X(-3617) / 510, X(43867) / 798, X(-174611) / 330
+	};
+
+	// out[0] = log Gamma(x), out[n] = psi^{(n-1)}(x), 1 <= n <= N, for x > 0.
+	// Shift z = x + m to where the asymptotic series is accurate using
+	// psi^{(n)}(x) = psi^{(n)}(x + 1) - (-1)^n n!/x^{n+1} and Gamma(x + 1) = x Gamma(x).
+	// The sums of (x + j)^{-n-1} over the shift are shared by all orders.
+	template<class X>
+		requires std::is_floating_point_v<X>
+	inline void lngamma_jet(X x, unsigned N, std::span<X> out)
+	{
+		const auto& B = bernoulli_2k<X>;
+		static constexpr unsigned K = sizeof(bernoulli_2k<X>) / sizeof(X);
+		static constexpr X ln_sqrt_2pi = X(0.918938533204672741780329736406);
+
+		ensure(x > 0);
+		ensure(out.size() > N);
+
+		for (unsigned n = 0; n <= N; ++n) {
+			out[n] = 0;
+		}
+
+		// log Gamma(z) = (z - 1/2) log z - z + log sqrt(2 pi) + sum_k B_{2k}/(2k (2k - 1) z^{2k - 1})
+		// z >= 10 is enough and keeps the terms that cancel small
+		X z = x;
+		X p = 1; // product of x + j
+		while (z < 10) {
+			p *= z;
+			z += 1;
+		}
+		X r = 1 / z;
+		X r2 = r * r;
+		X t = 0;
+		for (unsigned k = K; k >= 1; --k) {
+			t = t * r2 + B[k - 1] / (2 * k * (2 * k - 1));
+		}
+		out[0] = (z - X(0.5)) * std::log(z) - z + ln_sqrt_2pi + t * r - std::log(p);
+
+		if (N == 0) {
+			return;
+		}
+
+		// out[n + 1] accumulates sum_j (x + j)^{-n-1}
+		z = x;
+		X z0 = X(20 + N);
+		while (z < z0) {
+			r = 1 / z;
+			X r_n = r; // r^{n+1}
+			for (unsigned n = 0; n < N; ++n) {
+				out[n + 1] += r_n;
+				r_n *= r;
+			}
+			z += 1;
+		}
+		r = 1 / z;
+		r2 = r * r;
+		X lnz = std::log(z);
+
+		// psi(z) = log z - 1/(2z) - sum_k B_{2k}/(2k z^{2k})
+		t = 0;
+		for (unsigned k = K; k >= 1; --k) {
+			t = t * r2 + B[k - 1] / (2 * k);
+		}
+		out[1] = lnz - r / 2 - t * r2 - out[1];
+
+		// psi^{(n)}(z) = (-1)^{n+1} ((n - 1)!/z^n + n!/(2 z^{n+1}) + sum_k B_{2k} (2k + n - 1)!/((2k)! z^{2k + n}))
+		X n_1 = 1; // (n - 1)!
+		X r_n = r; // z^{-n}
+		for (unsigned n = 1; n < N; ++n) {
+			t = 0;
+			for (unsigned k = K; k >= 1; --k) {
+				X c = 1; // (2k + n - 1)!/(2k)!
+				for (unsigned j = 2 * k + 1; j < 2 * k + n; ++j) {
+					c *= j;
+				}
+				t = t * r2 + B[k - 1] * c;
+			}
+			X psi = n_1 * r_n * (1 + n * r / 2) + t * r_n * r2;
+			// psi^{(n)}(x) = psi^{(n)}(z) + (-1)^{n+1} n! sum_j (x + j)^{-n-1}
+			psi += n_1 * n * out[n + 1];
+			out[n + 1] = (n & 1) ? psi : -psi;
+
+			n_1 *= n;
+			r_n *= r;
+		}
+	}
+
+	// log Gamma(x)
+	template<class X>
+	inline X lngamma(X x)
+	{
+		X out[1];
+		lngamma_jet(x, 0, std::span<X>(out));
+
+		return out[0];
+	}
+
+	// log Gamma(z) for Re z > 0 up to a multiple of 2 pi i, so exp(lngamma(z)) = Gamma(z).
+	// Shift to |z| >= 10 using Gamma(z + 1) = z Gamma(z) and use the Stirling series.
+	template<class X>
+	inline std::complex<X> lngamma(std::complex<X> z)
+	{
+		static constexpr X ln_sqrt_2pi = X(0.918938533204672741780329736406);
+		static constexpr unsigned K = sizeof(bernoulli_2k<X>) / sizeof(X);
+
+		ensure(z.real() > 0);
+
+		std::complex<X> p = 1; // product of z + j
+		while (std::norm(z) < 100) {
+			p *= z;
+			z += 1;
+		}
+		std::complex<X> r = X(1) / z;
+		std::complex<X> r2 = r * r;
+		std::complex<X> t = 0;
+		for (unsigned k = K; k >= 1; --k) {
+			t = t * r2 + bernoulli_2k<X>[k - 1] / X(2 * k * (2 * k - 1));
+		}
+
+		return (z - X(0.5)) * std::log(z) - z + ln_sqrt_2pi + t * r - std::log(p);
+	}
+
+}
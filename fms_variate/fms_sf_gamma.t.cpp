@@ -0,0 +1,61 @@
+// fms_sf_gamma.t.cpp - test log gamma and polygamma jet
+#include <cassert>
+#include <gsl/gsl_sf_gamma.h>
+#include <gsl/gsl_sf_psi.h>
+#include "fms_test.h"
+#include "fms_sf_gamma.h"
+
+using namespace fms;
+using namespace fms::test;
+
+template<class X>
+int test_sf_lngamma_jet()
+{
+	constexpr unsigned N = 10;
+	X out[N + 1];
+
+	for (X x = X(0.01); x < 100; x *= X(1.01)) {
+		sf::lngamma_jet(x, N, std::span<X>(out));
+		X l = gsl_sf_lngamma(x);
+		assert(fabs(out[0] - l) <= 1e-14 * std::max(X(1), fabs(l)));
+		assert(sf::lngamma(x) == out[0]);
+		for (unsigned n = 1; n <= N; ++n) {
+			X psi = gsl_sf_psi_n(n - 1, x);
+			assert(fabs(out[n] - psi) <= 1e-14 * std::max(X(1), fabs(psi)));
+		}
+	}
+
+	return 0;
+}
+int test_sf_lngamma_jet_d = test_sf_lngamma_jet<double>();
+
+template<class X>
+int test_sf_lngamma_complex()
+{
+	using C = std::complex<X>;
+	static constexpr X pi = X(3.14159265358979323846);
+
+	for (X x = X(0.01); x < 100; x *= X(1.1)) {
+		C l = sf::lngamma(C(x, 0));
+		assert(fabs(l.real() - sf::lngamma(x)) <= 1e-14 * std::max(X(1), fabs(l.real())));
+		assert(l.imag() == 0);
+	}
+	for (X y = X(-50); y <= 50; y += X(0.37)) {
+		// |Gamma(1/2 + iy)|^2 = pi/cosh(pi y)
+		C l = sf::lngamma(C(X(0.5), y));
+		X l0 = (log(pi) - (pi * fabs(y) + log1p(exp(-2 * pi * fabs(y))) - log(X(2)))) / 2;
+		assert(fabs(l.real() - l0) <= 1e-13 * std::max(X(1), fabs(l0)));
+		// Gamma(z + 1) = z Gamma(z)
+		for (X x : { X(0.1), X(1.7), X(12) }) {
+			C z(x, y);
+			C d = exp(sf::lngamma(z + X(1)) - sf::lngamma(z)) / z;
+			assert(abs(d - X(1)) < 1e-12);
+		}
+		// conjugate symmetry
+		C z(X(2.5), y);
+		assert(abs(sf::lngamma(conj(z)) - conj(sf::lngamma(z))) < 1e-12 * std::max(X(1), abs(sf::lngamma(z))));
+	}
+
+	return 0;
+}
+int test_sf_lngamma_complex_d = test_sf_lngamma_complex<double>();
@@ -1,46 +1,219 @@
 // fms_sf_hypergeometric.h - Hypergeometric function
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <concepts>
+#include <cstddef>
 #include <initializer_list>
 #include <limits>
+#include <span>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_simd.h"
 
 namespace fms::sf {
 
-	template<class X>
-	using list = std::initializer_list<X>;
+	// P parameters stored by value, an aggregate so {a_1, ..., a_P} initializes it
+	template<class X, size_t P = std::dynamic_extent>
+	struct hypergeometric_parameters {
+		std::array<X, P> a;
+
+		std::span<const X> values() const
+		{
+			return a;
+		}
+		// each parameter broadcast to lanes V
+		template<class V>
+		std::array<V, P> lanes() const
+		{
+			std::array<V, P> v;
+			for (size_t i = 0; i < P; ++i) {
+				v[i] = V(a[i]);
+			}
+
+			return v;
+		}
+		// (a_1 + n) ... (a_P + n) unrolled at compile time
+		X shifted_product(X n) const
+		{
+			return[&]<size_t... i>(std::index_sequence<i...>) {
+				return (X(1) * ... * (a[i] + n));
+			}(std::make_index_sequence<P>{});
+		}
+	};
 
-	// primitive implementation of general hypergeometric function
+	// runtime number of parameters stored inline when there are only a few
 	template<class X>
+	class hypergeometric_parameters<X, std::dynamic_extent> {
+		static constexpr size_t small = 4;
+		size_t p;
+		std::array<X, small> local;
+		std::vector<X> heap;
+
+		const X* data() const
+		{
+			return p <= small ? local.data() : heap.data();
+		}
+	public:
+		hypergeometric_parameters(std::span<const X> a)
+			: p(a.size()), local{}
+		{
+			if (p <= small) {
+				std::copy(a.begin(), a.end(), local.begin());
+			}
+			else {
+				heap.assign(a.begin(), a.end());
+			}
+		}
+		hypergeometric_parameters(std::initializer_list<X> a)
+			: hypergeometric_parameters(std::span<const X>(a.begin(), a.size()))
+		{ }
+
+		std::span<const X> values() const
+		{
+			return std::span<const X>(data(), p);
+		}
+		template<class V>
+		std::vector<V> lanes() const
+		{
+			return std::vector<V>(values().begin(), values().end());
+		}
+		X shifted_product(X n) const
+		{
+			X prod = 1;
+			for (X ai : values()) {
+				prod *= ai + n;
+			}
+
+			return prod;
+		}
+	};
+
+	namespace lane {
+
+		// pFq at lanes x for parameter lanes a and b using the policy of Hypergeometric::value.
+		// Every lane keeps summing and its outputs are latched on the iteration it stops at so the
+		// stopping rule is not part of the dependency chain from one iteration to the next.
+		// The block continues until every lane has stopped.
+		template<class V, class A, class B>
+		inline void hypergeometric(const A& a, const B& b, V x, double eps, int skip, int terms,
+			V& F, V& dF, V& small, V& iters)
+		{
+			const V zero(0), one(1);
+			F = dF = small = iters = zero;
+			if (skip <= 0 or terms <= 0) {
+				return;
+			}
+
+			V t = one, sum = zero, maxF = one, n_small = zero, ignore(skip), stopped = zero;
+			for (int n = 0; n < terms and !V::all(zero < stopped); ++n) {
+				sum = sum + t;
+				maxF = max(maxF, abs(sum));
+				auto tiny = abs(t) < maxF * V(eps);
+				n_small = n_small + select(tiny, one, zero);
+				ignore = select(tiny, ignore - one, V(skip));
+
+				// t_{n+1} = t_n (a_1 + n)...(a_p + n)/((b_1 + n)...(b_q + n)) x/(n + 1)
+				V n_(n), an = one, bn = one;
+				for (const V& ai : a) {
+					an = an * (ai + n_);
+				}
+				for (const V& bj : b) {
+					bn = bn * (bj + n_);
+				}
+				V done = select(abs(an) <= zero, one, zero);
+
+				auto on = stopped <= zero;
+				F = select(on, sum, F);
+				dF = select(on, select(zero < done, zero, t), dF);
+				small = select(on, n_small, small);
+				iters = select(on, V(n + 1), iters);
+				stopped = select(zero < done, one, select(ignore <= zero, one, stopped));
+
+				t = t * (an * x / (bn * V(n + 1)));
+			}
+		}
+
+		// Blocks of lanes V over x, ab(k, m) returns the parameter lanes of x[k], ..., x[k + m - 1].
+		// The rows of out are value, tail error, small terms, and iterations for each x.
+		template<class V, class AB>
+		inline void hypergeometric(std::span<const double> x, std::span<double> out, const AB& ab,
+			double eps, int skip, int terms)
+		{
+			size_t N = x.size();
+			ensure(out.size() >= 4 * N);
+
+			for (size_t k = 0; k < N; k += V::size) {
+				size_t m = std::min(V::size, N - k);
+				double xk[V::size], row[4][V::size];
+				std::fill(xk, xk + V::size, x[k + m - 1]); // padded lanes repeat the last x
+				std::copy(x.begin() + k, x.begin() + k + m, xk);
+				const auto& [a, b] = ab(k, m);
+				V r[4];
+				hypergeometric(a, b, V::load(xk), eps, skip, terms, r[0], r[1], r[2], r[3]);
+				for (size_t i = 0; i < 4; ++i) {
+					r[i].store(row[i]);
+					std::copy(row[i], row[i] + m, out.begin() + i * N + k);
+				}
+			}
+		}
+
+	}
+
+	// General hypergeometric function with P numerator and Q denominator parameters.
+	// Terms are updated using t_{n+1} = t_n (a_1 + n)...(a_p + n)/((b_1 + n)...(b_q + n)) x/(n + 1)
+	// so no Pochhammer symbol, power, or factorial is formed on its own.
+	// The default arity is given at runtime.
+	template<class X, size_t P = std::dynamic_extent, size_t Q = std::dynamic_extent>
 		requires std::is_floating_point_v<X>
 	class Hypergeometric {
-		const list<X>& a;
-		const list<X>& b;
+		hypergeometric_parameters<X, P> a;
+		hypergeometric_parameters<X, Q> b;
 		X n;  // current n
-		X an; // (a)_n
-		X bn; // (b)_n
-		X xn; // x^n
-		X n_; // n!
+		X tn; // current term t_n
+		bool done; // some a_i + n = 0 so all following terms are 0
 		X pFq; // running value
 	public:
-		Hypergeometric(const list<X>& a, const list<X>& b)
-			: a(a), b(b), n(0), an(1), bn(1), xn(1), n_(1), pFq(0)
+		Hypergeometric(const hypergeometric_parameters<X, P>& a, const hypergeometric_parameters<X, Q>& b)
+			: a(a), b(b), n(0), tn(1), done(false), pFq(0)
+		{ }
+		Hypergeometric(const Hypergeometric&) = default;
+		Hypergeometric& operator=(const Hypergeometric&) = default;
+		~Hypergeometric()
 		{ }
 
+		std::span<const X> numerator() const
+		{
+			return a.values();
+		}
+		std::span<const X> denominator() const
+		{
+			return b.values();
+		}
+
+		// start over at n = 0
+		void reset()
+		{
+			n = 0;
+			tn = 1;
+			done = false;
+			pFq = 0;
+		}
+
 		// return next term
 		X next(X x)
 		{
-			X dF = (an / bn) * xn / n_;
+			X dF = tn;
 
-			for (X ai : a) {
-				an *= ai + n;
-			}
-			for (X bi : b) {
-				bn *= bi + n;
-			}
-			xn *= x;
-			n_ *= ++n;
+			X an = a.shifted_product(n);
+			X bn = b.shifted_product(n);
+			done = an == 0;
+			++n;
+			tn *= an * x / (bn * n);
 
 			return dF;
 		}
@@ -50,7 +223,7 @@ namespace fms::sf {
 		{
 			X F = pFq;
 
-			for (X bi : b) {
+			for (X bi : b.values()) {
 				F /= std::tgamma(bi);
 			}
 
@@ -59,8 +232,8 @@ namespace fms::sf {
 
 		// square root of machine epsilon
 		static constexpr X sqrt_eps = X(1) / (1ul << (std::numeric_limits<X>::digits / 2));
-		
-		// policy based convergence
+
+		// policy based convergence starting from n = 0
 		std::tuple<X, X, int, int> value(X x, X eps = sqrt_eps, int skip = 40, int terms = 40)
 		{
 			X dF = 0, maxF = 1;
@@ -68,8 +241,9 @@ namespace fms::sf {
 			int small = 0; // total number of terms skipped
 			int iters = 0; // number of iterations performed
 
-			// if (a)_n = 0 then all follwing terms are 0
-			while (an and ignore and terms - iters) {
+			reset();
+			// if (a)_n = 0 then all following terms are 0
+			while (!done and ignore and terms - iters) {
 
 				dF = next(x);
 				pFq += dF;
@@ -86,20 +260,84 @@ namespace fms::sf {
 				++iters;
 			}
 
-			return std::tuple(pFq, an == 0 ? 0 : dF, small, iters);
+			return std::tuple(pFq, done ? 0 : dF, small, iters);
+		}
+		// Rows of out are the value, tail error, small terms, and iterations for each x,
+		// the same as value(x[j]) evaluated in SIMD lanes.
+		void value(std::span<const X> x, std::span<X> out, X eps = sqrt_eps, int skip = 40, int terms = 40) const
+		{
+			size_t N = x.size();
+			ensure(out.size() >= 4 * N);
+
+			if constexpr (std::is_same_v<X, double>) {
+				if (simd::best() != simd::level::scalar) {
+					simd::widest([&](auto v) {
+						using V = decltype(v);
+						auto ab = std::pair(a.template lanes<V>(), b.template lanes<V>());
+						lane::hypergeometric<V>(x, out, [&ab](size_t, size_t) -> const auto& { return ab; }, eps, skip, terms);
+					});
+
+					return;
+				}
+			}
+			// without SIMD lanes value(x) stops on a branch instead of latching
+			Hypergeometric F(*this);
+			for (size_t j = 0; j < N; ++j) {
+				auto [Fj, dFj, small, iters] = F.value(x[j], eps, skip, terms);
+				out[j] = Fj;
+				out[N + j] = dFj;
+				out[2 * N + j] = X(small);
+				out[3 * N + j] = X(iters);
+			}
 		}
 	};
 
+	// pFq for N parameter tuples in structure of arrays form, a[i][j] is a_i of tuple j with argument x[j].
+	// The rows of out are value, tail error, small terms, and iterations for each tuple.
+	inline void HypergeometricPFQ(std::span<const std::span<const double>> a, std::span<const std::span<const double>> b,
+		std::span<const double> x, std::span<double> out,
+		double eps = Hypergeometric<double>::sqrt_eps, int skip = 40, int terms = 40)
+	{
+		size_t N = x.size();
+		for (const auto& ai : a) {
+			ensure(ai.size() == N);
+		}
+		for (const auto& bi : b) {
+			ensure(bi.size() == N);
+		}
+
+		simd::widest([&](auto v) {
+			using V = decltype(v);
+			std::pair<std::vector<V>, std::vector<V>> ab(a.size(), b.size());
+			// padded lanes repeat the last tuple
+			auto load = [](std::span<const double> p, size_t k, size_t m) {
+				double buf[V::size];
+				std::fill(buf, buf + V::size, p[k + m - 1]);
+				std::copy(p.begin() + k, p.begin() + k + m, buf);
+				return V::load(buf);
+			};
+			lane::hypergeometric<V>(x, out, [&](size_t k, size_t m) -> const auto& {
+				for (size_t i = 0; i < a.size(); ++i) {
+					ab.first[i] = load(a[i], k, m);
+				}
+				for (size_t i = 0; i < b.size(); ++i) {
+					ab.second[i] = load(b[i], k, m);
+				}
+				return ab;
+			}, eps, skip, terms);
+		});
+	}
+
 	// pFq(a,b,x) = sum_n (a_1)_n ... (a_p)_n/((b_1)_n ... (b_q)_n) x^n/n!
 	template<class X> requires std::is_floating_point_v<X>
-	static X HypergeometricPFQ(const list<X>& a, const list<X>& b, X x, bool regularized = false,
-		X eps = sqrt_eps, int skip = 40, int terms = 40)
+	inline X HypergeometricPFQ(std::span<const std::type_identity_t<X>> a, std::span<const std::type_identity_t<X>> b, X x, bool regularized = false,
+		X eps = Hypergeometric<X>::sqrt_eps, int skip = 40, int terms = 40)
 	{
-		Hypergeometric pFq(a, b, eps, skip, terms);
+		Hypergeometric<X> pFq(a, b);
 
-		auto F = pFq.value(x);
+		auto F = pFq.value(x, eps, skip, terms);
 
 		return regularized ? pFq.regularized() : std::get<0>(F);
 	}
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,9 @@
 ﻿// fms_variate_hypergeometric.t.cpp - General hypergeometric function
 #include <cassert>
 #include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
 #include "fms_test.h"
 #include "fms_sf_hypergeometric.h"
 
@@ -117,7 +120,143 @@ int test_hypergeometric()
 		}
 	}
 
+	// fixed arity is the same as runtime arity
+	{
+		X xs[] = { X(-.5), X(0.1), X(0.5) };
+
+		for (X x : xs) {
+			Hypergeometric<X, 2, 1> F_21({ X(.5), X(.5) }, { X(1.5) });
+			Hypergeometric<X> G_21({ X(.5), X(.5) }, { X(1.5) });
+			auto F = F_21.value(x * x, epsilon, 1, 40);
+			assert(F == G_21.value(x * x, epsilon, 1, 40));
+			// value starts over
+			assert(F == F_21.value(x * x, epsilon, 1, 40));
+		}
+	}
+	// parameters are owned
+	{
+		Hypergeometric<X> F_10({ X(-2) }, {});
+		auto G_10 = F_10;
+		assert(G_10.numerator().size() == 1 and G_10.numerator()[0] == X(-2));
+		assert(G_10.denominator().size() == 0);
+		assert(std::get<0>(G_10.value(X(3))) == X(4)); // (1 - 3)^2
+	}
+	// more parameters than stored inline, b_i = a_i + 1 so (a)_n/(b)_n = a/(a + n)
+	{
+		std::vector<X> a = { X(1), X(2), X(3), X(4), X(5) }, b = { X(2), X(3), X(4), X(5), X(6) };
+		a.push_back(1);
+		Hypergeometric<X> F{ std::span<const X>(a), std::span<const X>(b) };
+		Hypergeometric<X, 6, 5> G({ X(1), X(2), X(3), X(4), X(5), X(1) }, { X(2), X(3), X(4), X(5), X(6) });
+		X x = X(0.5);
+		auto [Fx, eps, small, iters] = F.value(x, epsilon, 1, 100);
+		assert(Fx == std::get<0>(G.value(x, epsilon, 1, 100)));
+		assert(Fx == HypergeometricPFQ<X>(a, b, x, false, epsilon, 1, 100));
+		// sum_n 120 x^n/((n + 1)...(n + 5))
+		X sum = 0;
+		for (int n = 0; n < 100; ++n) {
+			X m = X(n);
+			sum += 120 * pow(x, m) / ((m + 1) * (m + 2) * (m + 3) * (m + 4) * (m + 5));
+		}
+		assert(abs(Fx - sum) <= 4 * sum * epsilon);
+	}
+	// n! and x^n would overflow separately
+	if constexpr (std::is_same_v<X, double>) {
+		Hypergeometric<X, 0, 0> F_00({}, {});
+		X x = 100;
+		auto [F, eps, small, iters] = F_00.value(x, epsilon, 1, 400);
+		assert(iters > 171);
+		assert(abs(F - exp(x)) <= 100 * F * epsilon);
+	}
+
 	return 0;
 }
 int test_hypergeometric_d = test_hypergeometric<double>();
-int test_hypergeometric_f = test_hypergeometric<float>();
\ No newline at end of file
+int test_hypergeometric_f = test_hypergeometric<float>();
+
+// batch is the same as value at each x
+template<class X>
+int test_hypergeometric_batch()
+{
+	constexpr X epsilon = std::numeric_limits<X>::epsilon();
+
+	// 1F0(-2; x) terminates, 2F1 converges at different rates for each x
+	std::vector<X> x = { X(-0.9), X(-0.5), X(0), X(0.1), X(0.5), X(0.7), X(0.9), X(0.95), X(0.99), X(1.5), X(3) };
+	std::vector<X> out(4 * x.size());
+	auto check = [&](auto pFq, X eps, int skip, int terms) {
+		size_t N = x.size();
+		pFq.value(x, out, eps, skip, terms);
+		for (size_t j = 0; j < N; ++j) {
+			auto [F, dF, small, iters] = pFq.value(x[j], eps, skip, terms);
+			assert(out[j] == F or abs(out[j] - F) <= 4 * abs1(F) * epsilon); // divergent sums overflow
+			assert(out[N + j] == dF or abs(out[N + j] - dF) <= 4 * abs1(dF) * epsilon);
+			assert(out[2 * N + j] == small);
+			assert(out[3 * N + j] == iters);
+		}
+	};
+	check(Hypergeometric<X>({ X(-2) }, {}), epsilon, 1, 40);
+	check(Hypergeometric<X, 2, 1>({ X(.5), X(.5) }, { X(1.5) }), epsilon, 1, 200);
+	check(Hypergeometric<X>({ X(.5), X(.5) }, { X(1.5) }), epsilon, 3, 100);
+	check(Hypergeometric<X, 0, 0>({}, {}), epsilon, 1, 40);
+
+	if constexpr (std::is_same_v<X, double>) {
+		// parameter tuples in structure of arrays form
+		size_t N = x.size();
+		std::vector<X> a0(N), a1(N), b0(N);
+		for (size_t j = 0; j < N; ++j) {
+			a0[j] = X(0.5) + X(j) / 4;
+			a1[j] = j % 3 == 0 ? -X(j % 4) : X(1);
+			b0[j] = X(1.5) + X(j) / 8;
+		}
+		std::span<const X> a[] = { a0, a1 }, b[] = { b0 };
+		HypergeometricPFQ(a, b, x, out, epsilon, 1, 200);
+		for (size_t j = 0; j < N; ++j) {
+			Hypergeometric<X, 2, 1> pFq({ a0[j], a1[j] }, { b0[j] });
+			auto [F, dF, small, iters] = pFq.value(x[j], epsilon, 1, 200);
+			assert(out[j] == F or abs(out[j] - F) <= 4 * abs1(F) * epsilon); // divergent sums overflow
+			assert(out[N + j] == dF or abs(out[N + j] - dF) <= 4 * abs1(dF) * epsilon);
+			assert(out[2 * N + j] == small);
+			assert(out[3 * N + j] == iters);
+		}
+	}
+
+	return 0;
+}
+int test_hypergeometric_batch_d = test_hypergeometric_batch<double>();
+int test_hypergeometric_batch_f = test_hypergeometric_batch<float>();
+
+// one batch call against a fresh Hypergeometric per x, best of 8 trials
+int benchmark_hypergeometric_batch()
+{
+	std::vector<double> x(1 << 12), out(4 * x.size());
+	for (size_t j = 0; j < x.size(); ++j) {
+		x[j] = -0.9 + 1.8 * double(j) / x.size();
+	}
+	double eps = std::numeric_limits<double>::epsilon();
+
+	double sum_scalar = 0, sum_batch = 0;
+	double ms_scalar = fms::test::best(8, [&]() {
+		for (double xj : x) {
+			Hypergeometric<double> pFq({ 0.5, 0.5 }, { 1.5 });
+			sum_scalar += std::get<0>(pFq.value(xj, eps, 1, 400));
+		}
+	});
+	double ms_batch = fms::test::best(8, [&]() {
+		Hypergeometric<double> pFq({ 0.5, 0.5 }, { 1.5 });
+		pFq.value(x, out, eps, 1, 400);
+		for (size_t j = 0; j < x.size(); ++j) {
+			sum_batch += out[j];
+		}
+	});
+	fms::test::report("hypergeometric batch/scalar", ms_batch / ms_scalar);
+	assert(abs(sum_batch - sum_scalar) <= 1e-12 * abs(sum_scalar));
+	if (fms::simd::best() == fms::simd::level::scalar) {
+		// the benchmark inlines the literal parameters into each scalar call
+		assert(ms_batch < 4 * ms_scalar); // not horrible without SIMD
+	}
+	else {
+		assert(ms_batch < 2 * ms_scalar);
+	}
+
+	return 0;
+}
+int benchmark_hypergeometric_batch_ = benchmark_hypergeometric_batch();
\ No newline at end of file
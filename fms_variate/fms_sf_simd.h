@@ -0,0 +1,167 @@
+// fms_sf_simd.h - vectorized exp, log and erfc kernels
+#pragma once
+#include <limits>
+#include <span>
+#include "fms_simd.h"
+
+namespace fms::sf {
+
+	// Kernels on lanes V from fms_simd.h. Branch free with no table lookups.
+	namespace lane {
+
+		// e^{x + y} = 2^k e^r, |r| <= log(2)/2, with a degree 13 Taylor polynomial for e^r.
+		// The low part y must be small relative to x and is added after range reduction.
+		// Measured relative error is below 0.6 ulp for -708 < x < 709 (std::exp is 0.5 ulp),
+		// the result is 0 for x < -745.13 and inf for x > 709.78.
+		template<class V>
+		inline V exp(V x, V y)
+		{
+			static constexpr double ln2_hi = 6.93147180369123816490e-01; // low 32 bits are zero
+			static constexpr double ln2_lo = 1.90821492927058770002e-10;
+			static constexpr double c[] = { 
+				1., 1., 1. / 2, 1. / 6, 1. / 24, 1. / 120, 1. / 720, 1. / 5040, 1. / 40320, 
+				1. / 362880, 1. / 3628800, 1. / 39916800, 1. / 479001600, 1. / 6227020800 
+			};
+			static constexpr int n = sizeof(c) / sizeof(*c);
+
+			x = min(V(710.), max(V(-746.), x)); // propagates NaN
+			V k = round(x * V(1.44269504088896340736));
+			V r = fma(k, V(-ln2_hi), x); // exact
+			r = fma(k, V(-ln2_lo), r + y);
+
+			V p(c[n - 1]);
+			for (int j = n - 2; j >= 0; --j) {
+				p = fma(p, r, V(c[j]));
+			}
+
+			// split k so each power of 2 is a normal double
+			V k1 = floor(k * V(0.5));
+
+			return p * pow2(k1) * pow2(k - k1);
+		}
+		template<class V>
+		inline V exp(V x)
+		{
+			return exp(x, V(0));
+		}
+
+		// log(x) = e log(2) + log(m), sqrt(1/2) <= m < sqrt(2), using log(m) = 2 atanh((m - 1)/(m + 1)).
+		// Measured relative error is below 2 ulp for positive x.
+		template<class V>
+		inline V log(V x)
+		{
+			static constexpr double ln2_hi = 6.93147180369123816490e-01;
+			static constexpr double ln2_lo = 1.90821492927058770002e-10;
+			static constexpr double inf = std::numeric_limits<double>::infinity();
+			static constexpr double dbl_min = std::numeric_limits<double>::min();
+
+			// scale subnormals by 2^54
+			V sub = select(x < V(dbl_min), V(54), V(0));
+			V e;
+			V m = frexp2(select(x < V(dbl_min), x * V(18014398509481984.), x), e);
+			e = e - sub;
+			// sqrt(1/2) <= m < sqrt(2)
+			auto big = V(1.41421356237309504880) < m;
+			m = select(big, m * V(0.5), m);
+			e = select(big, e + V(1), e);
+
+			V f = (m - V(1)) / (m + V(1));
+			V s = f * f;
+			// 2 sum_{k>=0} f^{2k+1}/(2k+1)
+			V p(1. / 23);
+			for (int k = 21; k >= 1; k -= 2) {
+				p = fma(p, s, V(1. / k));
+			}
+			V r = fma(e, V(ln2_hi), fma(V(2) * f, p, e * V(ln2_lo)));
+
+			r = select(V(std::numeric_limits<double>::max()) < x, x, r); // inf
+			r = select(x <= V(0), V(-inf), r);
+			r = select(x < V(0), V(std::numeric_limits<double>::quiet_NaN()), r);
+
+			return select(x <= V(inf), r, x); // NaN
+		}
+
+		// erfc(z) = t exp(-z^2 + f(t)) for z >= 0 where t = 2/(2 + z) and f is a Chebyshev series 
+		// on 1/15 <= t <= 1. Measured relative error is below 2.6 ulp for -6 < z < 26.5 
+		// (std::erfc is 2.2 ulp), beyond that the result is subnormal or zero. erfc(-z) = 2 - erfc(z).
+		template<class V>
+		inline V erfc(V z)
+		{
+			static constexpr double t0 = 1. / 15; // z = 28
+			// Chebyshev coefficients of f on [t0, 1]
+			static constexpr double c[] = {
+				-6.12112796947552447335e-01,
+				6.06609323395592969492e-01,
+				1.40721642657178991785e-02,
+				-8.30924380805546492884e-03,
+				-5.53603888031184982583e-04,
+				2.91228350442060822292e-04,
+				1.63278956573161519594e-05,
+				-1.40097155427366259907e-05,
+				-3.74112133609316764935e-08,
+				7.32820459096116504062e-07,
+				-5.69680923284649831985e-08,
+				-3.55965751854577915757e-08,
+				6.84486611867752853933e-09,
+				1.29035325684243463303e-09,
+				-5.50518466026933030198e-10,
+				-4.98991540632837821107e-12,
+				3.26345738003693333616e-11,
+				-4.34590932847905148114e-12,
+				-1.21999522029875295816e-12,
+				4.35610586230900098670e-13,
+				-3.23431602680668284230e-15,
+				-2.30893646216423498171e-14,
+				4.28092619946668362366e-15,
+				3.78451610327790177744e-16,
+				-2.86223952525310743051e-16,
+				4.39291615236814259037e-17,
+			};
+			static constexpr int n = sizeof(c) / sizeof(*c);
+
+			V a = abs(z);
+			V t = V(2) / (V(2) + a);
+			V u = fma(max(V(t0), t), V(2 / (1 - t0)), V(-(1 + t0) / (1 - t0)));
+
+			// Clenshaw
+			V u2 = u + u;
+			V b(c[n - 1]), b_(0); // b_{k+1}, b_{k+2}
+			for (int k = n - 2; k > 0; --k) {
+				V b1 = fma(u2, b, V(c[k]) - b_);
+				b_ = b;
+				b = b1;
+			}
+			V f = fma(u, b, V(c[0]) - b_);
+
+			// -a^2 + f = x + y with a^2 = a2 + e and -a2 + f = x + y_ exactly
+			V a2 = a * a;
+			V e = mul_err(a, a, a2);
+			V x = f - a2;
+			V x_ = x - f;
+			V y = ((f - (x - x_)) + (-a2 - x_)) - e;
+			e = t * exp(x, y);
+
+			return select(z < V(0), V(2) - e, e);
+		}
+
+	}
+
+	// out[i] = exp(x[i]), x and out may alias
+	inline void exp(std::span<const double> x, std::span<double> out)
+	{
+		simd::transform(x, out, [](auto x) { return lane::exp(x); });
+	}
+
+	// out[i] = log(x[i]), x and out may alias
+	inline void log(std::span<const double> x, std::span<double> out)
+	{
+		simd::transform(x, out, [](auto x) { return lane::log(x); });
+	}
+
+	// out[i] = erfc(x[i]), x and out may alias
+	inline void erfc(std::span<const double> x, std::span<double> out)
+	{
+		simd::transform(x, out, [](auto x) { return lane::erfc(x); });
+	}
+
+}
@@ -0,0 +1,91 @@
+// fms_sf_simd.t.cpp - test vectorized exp, log, and erfc
+#include <cassert>
+#include <cfloat>
+#include <vector>
+#include "fms_test.h"
+#include "fms_sf_simd.h"
+
+using namespace fms;
+
+// maximum relative error in ulp of lanes V against long double
+template<class V, class F, class G>
+inline double max_ulp(const F& f, const G& g, double a, double b, double h)
+{
+	double ulp = 0;
+
+	for (double x = a; x < b; x += h) {
+		double buf[V::size];
+		for (auto& y : buf) {
+			y = x;
+		}
+		f(V::load(buf)).store(buf);
+		long double y = g((long double)x);
+		if (fabsl(y) >= DBL_MIN) {
+			ulp = std::max(ulp, double(fabsl((buf[0] - y) / y) / DBL_EPSILON));
+		}
+	}
+
+	return ulp;
+}
+
+template<class V>
+int test_sf_simd()
+{
+	auto exp_ = [](auto x) { return sf::lane::exp(x); };
+	auto log_ = [](auto x) { return sf::lane::log(x); };
+	auto erfc_ = [](auto x) { return sf::lane::erfc(x); };
+	auto expl_ = [](long double x) { return expl(x); };
+	auto logl_ = [](long double x) { return logl(x); };
+	auto erfcl_ = [](long double x) { return erfcl(x); };
+
+	assert(max_ulp<V>(exp_, expl_, -708, 709, 0.0137) < 1);
+	assert(max_ulp<V>(log_, logl_, 1e-6, 10, 0.000137) < 2);
+	assert(max_ulp<V>(log_, logl_, 10, 1e6, 13.7) < 2);
+	assert(max_ulp<V>(erfc_, erfcl_, -6, 26.5, 0.00137) < 3);
+
+	double x[] = { NAN, 800, -800, 30, -30 };
+	double y[5];
+	simd::transform<V>(x, y, 5, exp_);
+	assert(std::isnan(y[0]) and y[1] == INFINITY and y[2] == 0);
+	simd::transform<V>(x, y, 5, erfc_);
+	assert(std::isnan(y[0]) and y[1] == 0 and y[2] == 2 and y[3] == 0 and y[4] == 2);
+
+	double z[] = { NAN, INFINITY, 0, -1, 1, DBL_TRUE_MIN };
+	double w[6];
+	simd::transform<V>(z, w, 6, log_);
+	assert(std::isnan(w[0]) and w[1] == INFINITY and w[2] == -INFINITY and std::isnan(w[3]) and w[4] == 0);
+	assert(fabs(w[5] + 1074 * M_LN2) <= 2 * DBL_EPSILON * 1074 * M_LN2);
+
+	return 0;
+}
+int test_sf_simd_scalar = test_sf_simd<simd::scalar>();
+#if defined(FMS_SIMD_AVX2)
+int test_sf_simd_avx2 = simd::best() >= simd::level::avx2 ? test_sf_simd<simd::avx2>() : 0;
+#endif
+#if defined(FMS_SIMD_AVX512)
+int test_sf_simd_avx512 = simd::best() >= simd::level::avx512 ? test_sf_simd<simd::avx512>() : 0;
+#endif
+
+int test_sf_simd_batch()
+{
+	auto x = fms::test::range(-10., 10., 0.001);
+	std::vector<double> y(x.size());
+
+	sf::exp(std::span<const double>(&x[0], x.size()), y);
+	for (size_t i = 0; i < x.size(); ++i) {
+		assert(fabs(y[i] - std::exp(x[i])) <= 2 * DBL_EPSILON * y[i]);
+	}
+	sf::log(std::span<const double>(&x[0], x.size()), y);
+	for (size_t i = 0; i < x.size(); ++i) {
+		if (x[i] > 0) {
+			assert(fabs(y[i] - std::log(x[i])) <= 2 * DBL_EPSILON * fabs(y[i]) + DBL_MIN);
+		}
+	}
+	sf::erfc(std::span<const double>(&x[0], x.size()), y);
+	for (size_t i = 0; i < x.size(); ++i) {
+		assert(fabs(y[i] - std::erfc(x[i])) <= 8 * DBL_EPSILON * y[i]);
+	}
+
+	return 0;
+}
+int test_sf_simd_batch_ = test_sf_simd_batch();
@@ -0,0 +1,374 @@
+// fms_simd.h - SIMD lanes for batch kernels
+// Kernels are written once as templates over a lane type V and instantiated
+// for scalar, AVX2, and AVX-512 lanes. The widest lanes supported by both the
+// compiler and the CPU are selected at runtime.
+#pragma once
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "fms_ensure.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define FMS_SIMD_AVX2
+#if defined(_M_X64)
+#define FMS_SIMD_AVX512
+#endif
+#else
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define FMS_SIMD_AVX2
+#endif
+#if defined(__AVX512F__)
+#define FMS_SIMD_AVX512
+#endif
+#endif
+
+namespace fms::simd {
+
+	enum class level { scalar, avx2, avx512 };
+
+	// widest instruction set supported by the compiler and this CPU
+	inline level detect()
+	{
+#if defined(_MSC_VER) && defined(FMS_SIMD_AVX2)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return level::scalar;
+		}
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool fma = (info[2] & (1 << 12)) != 0;
+		if (!osxsave) {
+			return level::scalar;
+		}
+		unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		bool avx2 = fma and (info[1] & (1 << 5)) != 0 and (xcr0 & 0x6) == 0x6;
+		bool avx512 = avx2 and (info[1] & (1 << 16)) != 0 and (xcr0 & 0xE6) == 0xE6;
+#if defined(FMS_SIMD_AVX512)
+		if (avx512) {
+			return level::avx512;
+		}
+#endif
+		return avx2 ? level::avx2 : level::scalar;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#if defined(FMS_SIMD_AVX512)
+		if (__builtin_cpu_supports("avx512f")) {
+			return level::avx512;
+		}
+#endif
+#if defined(FMS_SIMD_AVX2)
+		if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma")) {
+			return level::avx2;
+		}
+#endif
+		return level::scalar;
+#else
+		return level::scalar;
+#endif
+	}
+
+	// detected once
+	inline level best()
+	{
+		static const level l = detect();
+
+		return l;
+	}
+
+	// hint that the cache line containing p will be read soon
+	inline void prefetch(const void* p)
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+		_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#elif defined(__GNUC__)
+		__builtin_prefetch(p);
+#else
+		(void)p;
+#endif
+	}
+
+	// Portable single lane. Written branch free so loops over it can be auto-vectorized.
+	struct scalar {
+		static constexpr size_t size = 1;
+		using mask = bool;
+		double v;
+
+		scalar(double v = 0)
+			: v(v)
+		{ }
+
+		static scalar load(const double* p)
+		{
+			return scalar(*p);
+		}
+		void store(double* p) const
+		{
+			*p = v;
+		}
+
+		friend scalar operator+(scalar a, scalar b) { return a.v + b.v; }
+		friend scalar operator-(scalar a, scalar b) { return a.v - b.v; }
+		friend scalar operator*(scalar a, scalar b) { return a.v * b.v; }
+		friend scalar operator/(scalar a, scalar b) { return a.v / b.v; }
+		friend scalar operator-(scalar a) { return -a.v; }
+		friend mask operator<(scalar a, scalar b) { return a.v < b.v; }
+		friend mask operator<=(scalar a, scalar b) { return a.v <= b.v; }
+
+		// a * b + c
+		friend scalar fma(scalar a, scalar b, scalar c) { return a.v * b.v + c.v; }
+		// a * b - ab exactly using Dekker's split
+		friend scalar mul_err(scalar a, scalar b, scalar ab)
+		{
+#ifdef FP_FAST_FMA
+			return std::fma(a.v, b.v, -ab.v);
+#else
+			static constexpr double C = 134217729.; // 2^27 + 1
+			double a_ = C * a.v, b_ = C * b.v;
+			double ah = a_ - (a_ - a.v), bh = b_ - (b_ - b.v);
+			double al = a.v - ah, bl = b.v - bh;
+
+			return ((ah * bh - ab.v) + ah * bl + al * bh) + al * bl;
+#endif
+		}
+		// b if either is NaN
+		friend scalar min(scalar a, scalar b) { return a.v < b.v ? a.v : b.v; }
+		friend scalar max(scalar a, scalar b) { return a.v > b.v ? a.v : b.v; }
+		friend scalar abs(scalar a) { return std::fabs(a.v); }
+		friend scalar floor(scalar a) { return std::floor(a.v); }
+		friend scalar round(scalar a) { return std::nearbyint(a.v); }
+		// m ? a : b
+		friend scalar select(mask m, scalar a, scalar b) { return m ? a.v : b.v; }
+		// p[i] for integer valued 0 <= i < 2^51
+		friend scalar gather(const double* p, scalar i) { return p[static_cast<size_t>(i.v)]; }
+		// 2^k for integer valued -1022 <= k <= 1023
+		friend scalar pow2(scalar k)
+		{
+			return std::bit_cast<double>(static_cast<uint64_t>(static_cast<int64_t>(k.v) + 1023) << 52);
+		}
+		// x = m 2^e with 1 <= m < 2 for positive normal x
+		friend scalar frexp2(scalar x, scalar& e)
+		{
+			uint64_t i = std::bit_cast<uint64_t>(x.v);
+			e = double(static_cast<int>(i >> 52) - 1023);
+
+			return std::bit_cast<double>((i & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull);
+		}
+		// true if all lanes are set
+		static bool all(mask m)
+		{
+			return m;
+		}
+	};
+
+#if defined(FMS_SIMD_AVX2)
+	// 4 doubles
+	struct avx2 {
+		static constexpr size_t size = 4;
+		using mask = __m256d;
+		__m256d v;
+
+		avx2(double x = 0)
+			: v(_mm256_set1_pd(x))
+		{ }
+		avx2(__m256d v)
+			: v(v)
+		{ }
+
+		static avx2 load(const double* p)
+		{
+			return _mm256_loadu_pd(p);
+		}
+		void store(double* p) const
+		{
+			_mm256_storeu_pd(p, v);
+		}
+
+		friend avx2 operator+(avx2 a, avx2 b) { return _mm256_add_pd(a.v, b.v); }
+		friend avx2 operator-(avx2 a, avx2 b) { return _mm256_sub_pd(a.v, b.v); }
+		friend avx2 operator*(avx2 a, avx2 b) { return _mm256_mul_pd(a.v, b.v); }
+		friend avx2 operator/(avx2 a, avx2 b) { return _mm256_div_pd(a.v, b.v); }
+		friend avx2 operator-(avx2 a) { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.)); }
+		friend mask operator<(avx2 a, avx2 b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+		friend mask operator<=(avx2 a, avx2 b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+
+		friend avx2 fma(avx2 a, avx2 b, avx2 c) { return _mm256_fmadd_pd(a.v, b.v, c.v); }
+		friend avx2 mul_err(avx2 a, avx2 b, avx2 ab) { return _mm256_fmsub_pd(a.v, b.v, ab.v); }
+		friend avx2 min(avx2 a, avx2 b) { return _mm256_min_pd(a.v, b.v); }
+		friend avx2 max(avx2 a, avx2 b) { return _mm256_max_pd(a.v, b.v); }
+		friend avx2 abs(avx2 a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), a.v); }
+		friend avx2 floor(avx2 a) { return _mm256_floor_pd(a.v); }
+		friend avx2 round(avx2 a) { return _mm256_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		friend avx2 select(mask m, avx2 a, avx2 b) { return _mm256_blendv_pd(b.v, a.v, m); }
+		// 1.5 2^52 + i has i in the low bits
+		friend avx2 gather(const double* p, avx2 i)
+		{
+			__m256d b = _mm256_set1_pd(6755399441055744.);
+			__m256i k = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(i.v, b)), _mm256_castpd_si256(b));
+
+			return _mm256_i64gather_pd(p, k, 8);
+		}
+		// 1.5 2^52 + k has k in the low bits
+		friend avx2 pow2(avx2 k)
+		{
+			__m256i i = _mm256_castpd_si256(_mm256_add_pd(k.v, _mm256_set1_pd(6755399441055744.)));
+			i = _mm256_add_epi64(i, _mm256_set1_epi64x(1023));
+
+			return _mm256_castsi256_pd(_mm256_slli_epi64(i, 52));
+		}
+		// or with the bits of 2^52 to convert the exponent to double
+		friend avx2 frexp2(avx2 x, avx2& e)
+		{
+			__m256i i = _mm256_castpd_si256(x.v);
+			__m256d e_ = _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(i, 52), _mm256_set1_epi64x(0x4330000000000000ll)));
+			e = _mm256_sub_pd(e_, _mm256_set1_pd(4503599627371519.)); // 2^52 + 1023
+			i = _mm256_and_si256(i, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFll));
+
+			return _mm256_castsi256_pd(_mm256_or_si256(i, _mm256_set1_epi64x(0x3FF0000000000000ll)));
+		}
+		static bool all(mask m)
+		{
+			return _mm256_movemask_pd(m) == 0xF;
+		}
+	};
+#endif // FMS_SIMD_AVX2
+
+#if defined(FMS_SIMD_AVX512)
+	// 8 doubles
+	struct avx512 {
+		static constexpr size_t size = 8;
+		using mask = __mmask8;
+		__m512d v;
+
+		avx512(double x = 0)
+			: v(_mm512_set1_pd(x))
+		{ }
+		avx512(__m512d v)
+			: v(v)
+		{ }
+
+		static avx512 load(const double* p)
+		{
+			return _mm512_loadu_pd(p);
+		}
+		void store(double* p) const
+		{
+			_mm512_storeu_pd(p, v);
+		}
+
+		friend avx512 operator+(avx512 a, avx512 b) { return _mm512_add_pd(a.v, b.v); }
+		friend avx512 operator-(avx512 a, avx512 b) { return _mm512_sub_pd(a.v, b.v); }
+		friend avx512 operator*(avx512 a, avx512 b) { return _mm512_mul_pd(a.v, b.v); }
+		friend avx512 operator/(avx512 a, avx512 b) { return _mm512_div_pd(a.v, b.v); }
+		friend avx512 operator-(avx512 a) { return _mm512_sub_pd(_mm512_set1_pd(-0.), a.v); }
+		friend mask operator<(avx512 a, avx512 b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ); }
+		friend mask operator<=(avx512 a, avx512 b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ); }
+
+		friend avx512 fma(avx512 a, avx512 b, avx512 c) { return _mm512_fmadd_pd(a.v, b.v, c.v); }
+		friend avx512 mul_err(avx512 a, avx512 b, avx512 ab) { return _mm512_fmsub_pd(a.v, b.v, ab.v); }
+		friend avx512 min(avx512 a, avx512 b) { return _mm512_min_pd(a.v, b.v); }
+		friend avx512 max(avx512 a, avx512 b) { return _mm512_max_pd(a.v, b.v); }
+		friend avx512 abs(avx512 a) { return _mm512_abs_pd(a.v); }
+		friend avx512 floor(avx512 a) { return _mm512_roundscale_pd(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+		friend avx512 round(avx512 a) { return _mm512_roundscale_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		friend avx512 select(mask m, avx512 a, avx512 b) { return _mm512_mask_blend_pd(m, b.v, a.v); }
+		friend avx512 gather(const double* p, avx512 i)
+		{
+			__m512d b = _mm512_set1_pd(6755399441055744.);
+			__m512i k = _mm512_sub_epi64(_mm512_castpd_si512(_mm512_add_pd(i.v, b)), _mm512_castpd_si512(b));
+
+			return _mm512_i64gather_pd(k, p, 8);
+		}
+		friend avx512 pow2(avx512 k)
+		{
+			__m512i i = _mm512_castpd_si512(_mm512_add_pd(k.v, _mm512_set1_pd(6755399441055744.)));
+			i = _mm512_add_epi64(i, _mm512_set1_epi64(1023));
+
+			return _mm512_castsi512_pd(_mm512_slli_epi64(i, 52));
+		}
+		friend avx512 frexp2(avx512 x, avx512& e)
+		{
+			__m512i i = _mm512_castpd_si512(x.v);
+			__m512d e_ = _mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(i, 52), _mm512_set1_epi64(0x4330000000000000ll)));
+			e = _mm512_sub_pd(e_, _mm512_set1_pd(4503599627371519.)); // 2^52 + 1023
+			i = _mm512_and_si512(i, _mm512_set1_epi64(0x000FFFFFFFFFFFFFll));
+
+			return _mm512_castsi512_pd(_mm512_or_si512(i, _mm512_set1_epi64(0x3FF0000000000000ll)));
+		}
+		static bool all(mask m)
+		{
+			return m == 0xFF;
+		}
+	};
+#endif // FMS_SIMD_AVX512
+
+	// out[i] = f(x[i]) for lanes V, the tail is padded to a full lane
+	template<class V, class F>
+	inline void transform(const double* x, double* out, size_t n, const F& f)
+	{
+		size_t i = 0;
+
+		for (; i + V::size <= n; i += V::size) {
+			f(V::load(x + i)).store(out + i);
+		}
+		if (i < n) {
+			double buf[V::size] = { 0 };
+			for (size_t j = i; j < n; ++j) {
+				buf[j - i] = x[j];
+			}
+			f(V::load(buf)).store(buf);
+			for (size_t j = i; j < n; ++j) {
+				out[j] = buf[j - i];
+			}
+		}
+	}
+
+	// f(V()) for the widest lanes V available, f must be callable with every lane type
+	template<class F>
+	inline void widest(const F& f)
+	{
+		switch (best()) {
+#if defined(FMS_SIMD_AVX512)
+		case level::avx512:
+			f(avx512());
+			break;
+#endif
+#if defined(FMS_SIMD_AVX2)
+		case level::avx2:
+			f(avx2());
+			break;
+#endif
+		default:
+			f(scalar());
+		}
+	}
+
+	// out[i] = f(x[i]) using the widest lanes available, x and out may alias
+	// f must be callable with every lane type
+	template<class F>
+	inline void transform(std::span<const double> x, std::span<double> out, const F& f)
+	{
+		ensure(out.size() >= x.size());
+
+		switch (best()) {
+#if defined(FMS_SIMD_AVX512)
+		case level::avx512:
+			transform<avx512>(x.data(), out.data(), x.size(), f);
+			break;
+#endif
+#if defined(FMS_SIMD_AVX2)
+		case level::avx2:
+			transform<avx2>(x.data(), out.data(), x.size(), f);
+			break;
+#endif
+		default:
+			transform<scalar>(x.data(), out.data(), x.size(), f);
+		}
+	}
+
+}
@@ -5,7 +5,10 @@
 #include <chrono>
 #include <functional>
 #include <initializer_list>
+#include <string>
+#include <utility>
 #include <valarray>
+#include <vector>
 
 namespace fms::test {
 
@@ -25,6 +28,31 @@ namespace fms::test {
 
 		return 1000*std::chrono::duration<double>(stop - start).count();
 	}
+	// smallest time in milliseconds over n trials
+	template<class F>
+	inline double best(unsigned n, const F& f)
+	{
+		double ms = time(f);
+		while (--n > 0) {
+			ms = std::min(ms, time(f));
+		}
+
+		return ms;
+	}
+
+	// named benchmark results in the order reported, printed by main
+	inline std::vector<std::pair<std::string, double>>& results()
+	{
+		static std::vector<std::pair<std::string, double>> r;
+
+		return r;
+	}
+	inline double report(const std::string& name, double value)
+	{
+		results().emplace_back(name, value);
+
+		return value;
+	}
 
 	// f'(x) + f'''(x)h^2/6 + ...
 	template<class F, class X>
@@ -1,6 +1,8 @@
 // fms_variate.cpp - random variates
 #include <cassert>
+#include <cstdio>
 #include <limits>
+#include "fms_test.h"
 #include "fms_variate.h"
 #include "fms_variate_constant.h"
 #include "fms_variate_normal.h"
@@ -39,5 +41,10 @@ int test_standard_variate_normal = test_variate(standard_normal<double>{});
 
 int main()
 {
+	// benchmark results from the static test initializers
+	for (const auto& [name, value] : test::results()) {
+		printf("%s\t%g\n", name.c_str(), value);
+	}
+
 	return 0;
 }
\ No newline at end of file
@@ -1,7 +1,17 @@
 ﻿// fms_variate.h - Random variates.
 #pragma once
+#include <algorithm>
 #include <concepts>
 #include <cmath>
+#include <complex>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "fms_ensure.h"
 
 #define FMS_DOC(name) inline static const char name ## _doc[]
 #define FMS_HELP(name) inline static const char name ## _help[]
@@ -16,6 +26,69 @@ namespace fms {
 		{ v.edf(s, x) } -> std::convertible_to<X>;
 	};
 
+	// optional single pass evaluation of cdf(x, s, 0), ..., cdf(x, s, N)
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_jet_concept = variate_concept<V, X, S> 
+		and requires (const V v, X x, S s, unsigned N, std::span<X> out) {
+			v.cdf_jet(x, s, N, out);
+		};
+
+	// optional batch evaluation of cdf(x[i], s, n) where x and out may alias
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_batch_concept = variate_concept<V, X, S>
+		and requires (const V v, std::span<const X> x, S s, unsigned n, std::span<X> out) {
+			v.cdf(x, s, n, out);
+		};
+
+	// optional batch evaluation of edf(s, x[i]) where x and out may alias
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_edf_batch_concept = variate_concept<V, X, S>
+		and requires (const V v, S s, std::span<const X> x, std::span<X> out) {
+			v.edf(s, x, out);
+		};
+
+	// optional closed form inverse of cdf(x, s)
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_quantile_concept = variate_concept<V, X, S>
+		and requires (const V v, X p, S s) {
+			{ v.quantile(p, s) } -> std::convertible_to<X>;
+		};
+
+	// optional batch quantile(p[i], s) where p and out may alias
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_quantile_batch_concept = variate_concept<V, X, S>
+		and requires (const V v, std::span<const X> p, S s, std::span<X> out) {
+			v.quantile(p, s, out);
+		};
+
+	// optional member filling out with draws from X_s
+	template<typename V, class G, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_sample_concept = variate_concept<V, X, S>
+		and requires (const V v, G& g, std::span<X> out, S s) {
+			v.sample(g, out, s);
+		};
+
+	// optional single pass evaluation of cumulant(s, 0), ..., cumulant(s, N)
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_cumulant_jet_concept = variate_concept<V, X, S>
+		and requires (const V v, S s, unsigned N, std::span<S> out) {
+			v.cumulant_jet(s, N, out);
+		};
+
+	// optional batch evaluation of cumulant(s[i], n) where s and out may alias
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_cumulant_batch_concept = variate_concept<V, X, S>
+		and requires (const V v, std::span<const S> s, unsigned n, std::span<S> out) {
+			v.cumulant(s, n, out);
+		};
+
+	// optional cumulant log E[exp(z X)] at complex z
+	template<typename V, class X = typename V::xtype, class S = typename V::stype>
+	concept variate_cumulant_complex_concept = variate_concept<V, X, S>
+		and requires (const V v, std::complex<S> z) {
+			{ v.cumulant(z) } -> std::convertible_to<std::complex<S>>;
+		};
+
 	//inline static const char8_t* fms_variate_documentation 
 	FMS_DOC(variate) = R"xyzyx(
 A random variable \(X\) is determined by its cumulative distribution function \(F(x) = P(X <= x)\). 
@@ -28,30 +101,457 @@ where edf is the derivative of the cdf of \(X_s\) with respect to s.
 
 	namespace variate {
 
+		FMS_DOC(cdf_jet) = R"xyzyx(
+Returns the derivatives \(F_s(x), F_s'(x), \ldots, F_s^{(N)}(x)\) of the Esscher transformed cumulative distribution.
+Variates that can share work across derivatives implement <code>cdf_jet</code>, 
+otherwise <code>cdf</code> is called \(N + 1\) times.
+)xyzyx";
+		template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+		inline void cdf_jet(const V& v, X x, S s, unsigned N, std::span<X> out)
+		{
+			ensure(out.size() > N);
+
+			if constexpr (variate_jet_concept<V, X, S>) {
+				v.cdf_jet(x, s, N, out);
+			}
+			else {
+				for (unsigned n = 0; n <= N; ++n) {
+					out[n] = v.cdf(x, s, n);
+				}
+			}
+		}
+
+		// out[i] = cdf(x[i], s, n) using the batch member if the variate has one
+		template<variate_concept V>
+		inline void cdf(const V& v, std::span<const typename V::xtype> x, typename V::stype s, unsigned n,
+			std::span<typename V::xtype> out)
+		{
+			ensure(out.size() >= x.size());
+
+			if constexpr (variate_batch_concept<V>) {
+				v.cdf(x, s, n, out);
+			}
+			else {
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = v.cdf(x[i], s, n);
+				}
+			}
+		}
+
+		// out[i] = edf(s, x[i]) using the batch member if the variate has one
+		template<variate_concept V>
+		inline void edf(const V& v, typename V::stype s, std::span<const typename V::xtype> x,
+			std::span<typename V::xtype> out)
+		{
+			ensure(out.size() >= x.size());
+
+			if constexpr (variate_edf_batch_concept<V>) {
+				v.edf(s, x, out);
+			}
+			else {
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = v.edf(s, x[i]);
+				}
+			}
+		}
+
+		// cumulant(s, 0), ..., cumulant(s, N) using the jet member if the variate has one
+		template<variate_concept V, class S = typename V::stype>
+		inline void cumulant_jet(const V& v, S s, unsigned N, std::span<S> out)
+		{
+			ensure(out.size() > N);
+
+			if constexpr (variate_cumulant_jet_concept<V>) {
+				v.cumulant_jet(s, N, out);
+			}
+			else {
+				for (unsigned n = 0; n <= N; ++n) {
+					out[n] = v.cumulant(s, n);
+				}
+			}
+		}
+
+		// out[i] = cumulant(s[i], n) using the batch member if the variate has one
+		template<variate_concept V>
+		inline void cumulant(const V& v, std::span<const typename V::stype> s, unsigned n,
+			std::span<typename V::stype> out)
+		{
+			ensure(out.size() >= s.size());
+
+			if constexpr (variate_cumulant_batch_concept<V>) {
+				v.cumulant(s, n, out);
+			}
+			else {
+				for (size_t i = 0; i < s.size(); ++i) {
+					out[i] = v.cumulant(s[i], n);
+				}
+			}
+		}
+
+		// kappa[k] for 2 <= k <= N from central moments mu[k] = E[(X - E[X])^k] using
+		// kappa_k = mu_k - sum_{j=2}^{k-2} C(k - 1, j - 1) kappa_j mu_{k - j}
+		template<class S>
+		inline void cumulant_from_central(std::span<const S> mu, unsigned N, std::span<S> kappa)
+		{
+			ensure(mu.size() > N and kappa.size() > N);
+
+			for (unsigned k = 2; k <= N; ++k) {
+				S kk = mu[k], C = 1; // C(k - 1, j - 1)
+				for (unsigned j = 2; j + 2 <= k; ++j) {
+					C = C * S(k - j + 1) / S(j - 1);
+					kk -= C * kappa[j] * mu[k - j];
+				}
+				kappa[k] = kk;
+			}
+		}
+
+		FMS_DOC(characteristic) = R"xyzyx(
+Returns the characteristic function \(E_s[\exp(iuX)] = \exp(\kappa(s + iu) - \kappa(s))\) of the Esscher transformed variate
+for variates that implement the cumulant at complex arguments.
+)xyzyx";
+		template<variate_concept V, class S = typename V::stype>
+			requires variate_cumulant_complex_concept<V>
+		inline std::complex<S> characteristic(const V& v, S u, S s = 0)
+		{
+			return exp(v.cumulant(std::complex<S>(s, u)) - v.cumulant(s, 0));
+		}
+
+		// Solve cumulant(s, 1) = x for s, the Esscher transform with E_s[X] = x, starting at s.
+		// Newton steps on the increasing function kappa' that leave the bracket bisect and
+		// steps outside the domain of the cumulant, where it throws, are halved.
+		template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+		inline S cumulant_solve(const V& v, X x, S s = 0)
+		{
+			static constexpr S eps = std::numeric_limits<S>::epsilon();
+			static constexpr int max_iter = 100;
+			constexpr S inf = std::numeric_limits<S>::infinity();
+
+			S K[3]; // kappa, kappa', kappa''
+			cumulant_jet(v, s, 2, std::span<S>(K));
+			S lo = -inf, hi = inf; // kappa'(lo) < x < kappa'(hi)
+			for (int i = 0; i < max_iter; ++i) {
+				S f = K[1] - x;
+				if (f == 0) {
+					break;
+				}
+				if (f < 0) {
+					lo = s;
+				}
+				else {
+					hi = s;
+				}
+				ensure(K[2] > 0);
+				S s_ = s - f / K[2];
+				if (!(lo < s_ and s_ < hi) and std::isfinite(lo) and std::isfinite(hi)) {
+					s_ = lo + (hi - lo) / 2;
+				}
+				for (;;) {
+					try {
+						cumulant_jet(v, s_, 2, std::span<S>(K));
+						if (std::isfinite(K[1]) and std::isfinite(K[2])) {
+							break;
+						}
+					}
+					catch (const std::runtime_error&) {
+					}
+					// the root is between s and s_
+					(s_ < s ? lo : hi) = s_;
+					s_ = s + (s_ - s) / 2;
+					ensure(s_ != s);
+				}
+				S ds = s_ - s;
+				s = s_;
+				if (fabs(ds) <= 4 * eps * std::max(S(1), fabs(s))) {
+					break;
+				}
+			}
+
+			return s;
+		}
+
+		FMS_DOC(quantile) = R"xyzyx(
+Returns the smallest \(x\) with \(F_s(x) \ge p\), the inverse of the Esscher transformed cumulative distribution.
+Variates with a closed form implement <code>quantile</code>. Otherwise the root is bracketed 
+starting from the mean and standard deviation given by the cumulant and polished with Halley steps 
+using the first two derivatives of the cdf.
+)xyzyx";
+
+		// rough standard normal quantile, |error| < 4.5e-4, Abramowitz and Stegun 26.2.23
+		template<class X>
+		inline X normal_quantile_guess(X p)
+		{
+			X q = p < X(0.5) ? p : 1 - p;
+			X t = sqrt(-2 * log(q));
+			X z = t - (X(2.515517) + t * (X(0.802853) + t * X(0.010328)))
+				/ (1 + t * (X(1.432788) + t * (X(0.189269) + t * X(0.001308))));
+
+			return p < X(0.5) ? -z : z;
+		}
+
+		// Solve cdf(x, s) = p for 0 < p < 1 starting at x with step h > 0.
+		// Step out from x doubling h until the root is bracketed, then take Halley steps
+		// that fall back to bisection when they leave the bracket.
+		template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+		inline X quantile_solve(const V& v, X p, S s, X x, X h)
+		{
+			static constexpr X eps = std::numeric_limits<X>::epsilon();
+			static constexpr int max_iter = 200;
+
+			ensure(0 < p and p < 1);
+			ensure(h > 0);
+
+			X lo, hi, f = v.cdf(x, s, 0) - p;
+			if (f < 0) {
+				lo = x;
+				for (hi = x + h; v.cdf(hi, s, 0) < p; hi += h) {
+					lo = hi;
+					h *= 2;
+					ensure(std::isfinite(hi));
+				}
+			}
+			else {
+				hi = x;
+				for (lo = x - h; v.cdf(lo, s, 0) >= p; lo -= h) {
+					hi = lo;
+					h *= 2;
+					ensure(std::isfinite(lo));
+				}
+			}
+
+			// cdf(lo) < p <= cdf(hi) and x is lo or hi
+			// Halley steps converge cubically so a step smaller than eps^(1/3) is the last one.
+			static const X tol = std::cbrt(eps);
+			X F[3];
+			for (int i = 0; i < max_iter and hi - lo > eps * std::max(fabs(lo), fabs(hi)); ++i) {
+				cdf_jet(v, x, s, 2, std::span<X>(F));
+				f = F[0] - p;
+				if (f < 0) {
+					lo = x;
+				}
+				else {
+					hi = x;
+				}
+				X dx = -f / F[1];
+				dx /= 1 + dx * F[2] / (2 * F[1]);
+				X x_ = x + dx;
+				if (lo < x_ and x_ < hi) {
+					x = x_;
+					if (fabs(dx) <= tol * std::max(X(1), fabs(x))) {
+						break;
+					}
+				}
+				else {
+					x = lo + (hi - lo) / 2;
+				}
+			}
+
+			return x;
+		}
+
+		template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+		inline X quantile(const V& v, X p, S s = 0)
+		{
+			if constexpr (variate_quantile_concept<V, X, S>) {
+				return v.quantile(p, s);
+			}
+			else {
+				ensure(0 <= p and p <= 1);
+
+				if (p == 0) {
+					return -std::numeric_limits<X>::infinity();
+				}
+				if (p == 1) {
+					return std::numeric_limits<X>::infinity();
+				}
+
+				// mean and standard deviation of X_s
+				X m = v.cumulant(s, 1);
+				X sd = sqrt(v.cumulant(s, 2));
+				if (!(sd > 0 and std::isfinite(sd))) {
+					sd = 1;
+				}
+
+				return quantile_solve(v, p, s, m + sd * normal_quantile_guess(p), sd);
+			}
+		}
+
+		// out[i] = quantile(p[i], s) solving the roots in increasing order of p starting from the previous one,
+		// x_i = x_{i-1} + (p_i - p_{i-1})/cdf(x_{i-1}, s, 1), unless that step is more than a standard deviation.
+		template<variate_concept V>
+		inline void quantile_warm(const V& v, std::span<const typename V::xtype> p, typename V::stype s,
+			std::span<typename V::xtype> out)
+		{
+			using X = typename V::xtype;
+
+			ensure(out.size() >= p.size());
+
+			for (X pi : p) {
+				ensure(0 <= pi and pi <= 1);
+			}
+			std::vector<size_t> k(p.size());
+			std::iota(k.begin(), k.end(), size_t(0));
+			if (!std::is_sorted(p.begin(), p.end())) {
+				std::sort(k.begin(), k.end(), [p](size_t i, size_t j) { return p[i] < p[j]; });
+			}
+
+			X sd = p.size() > 1 ? sqrt(v.cumulant(s, 2)) : 0;
+			X p_ = 0, x_ = 0; // previous p and root
+			bool warm = false;
+			for (size_t i : k) {
+				X pi = p[i]; // p and out may alias
+				X dx = warm and 0 < pi and pi < 1 ? (pi - p_) / v.cdf(x_, s, 1) : 0;
+				if (dx != 0 and fabs(dx) <= sd) {
+					out[i] = quantile_solve(v, pi, s, x_ + dx, fabs(dx));
+				}
+				else {
+					out[i] = quantile(v, pi, s);
+				}
+				warm = std::isfinite(out[i]);
+				p_ = pi;
+				x_ = out[i];
+			}
+		}
+
+		// out[i] = quantile(p[i], s), p and out may alias
+		template<variate_concept V>
+		inline void quantile(const V& v, std::span<const typename V::xtype> p, typename V::stype s,
+			std::span<typename V::xtype> out)
+		{
+			ensure(out.size() >= p.size());
+
+			if constexpr (variate_quantile_batch_concept<V>) {
+				v.quantile(p, s, out);
+			}
+			else if constexpr (variate_quantile_concept<V>) {
+				for (size_t i = 0; i < p.size(); ++i) {
+					out[i] = v.quantile(p[i], s);
+				}
+			}
+			else {
+				quantile_warm(v, p, s, out);
+			}
+		}
+
+		// X_s draws using v.sample if defined, otherwise inverting uniforms, in fms_variate_sample.h
+		template<variate_concept V, std::uniform_random_bit_generator G>
+		inline void sample(const V& v, G& g, std::span<typename V::xtype> out, typename V::stype s = 0);
+
 		// affine transformation mu + sigma X
 		FMS_HELP(affine) = R"(Affine transformation mu + sigma X)";
 		FMS_DOC(affine) = R"xyzyx(
-Given a variate \(X\) construct the variate \(\mu + \sigma X\).
+Given a variate \(X\) construct the variate \(\mu + \sigma X\) for \(\sigma \ne 0\).
+The variate is held by value and \(\mu + \sigma(m + sX)\) is folded to \((\mu + \sigma m) + \sigma sX\)
+so evaluation is a single transformation.
+If \(\sigma < 0\) the cdf is \(1 - P(X < (x - \mu)/\sigma)\) so atoms of \(X\) are included.
 )xyzyx";
 		template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
 		class affine {
-			const V& v;
+			V v; // held by value so temporaries do not dangle
 			X mu, sigma;
+
+			// largest representable number less than y
+			static X below(X y)
+			{
+				return std::nextafter(y, -std::numeric_limits<X>::infinity());
+			}
+			// P_{sigma s}(X < y)
+			X left(X y, S s) const
+			{
+				return v.cdf(below(y), sigma * s, 0);
+			}
+			// largest y with P_{sigma s}(X >= y) >= p, the quantile is mu + sigma y for sigma < 0
+			X reflect(X p, S s) const
+			{
+				X q = 1 - p;
+				X y = variate::quantile(v, q, sigma * s);
+				if (q < 1 and v.cdf(y, sigma * s, 0) <= q) {
+					// F(y) = q so P(X < y') = q up to the next atom y', or the smallest atom if q = 0
+					y = variate::quantile(v, std::nextafter(q, X(1)), sigma * s);
+				}
+
+				return y;
+			}
 		public:
 			typedef X xtype;
 			typedef S stype;
 
 			affine(const V& v, X mu = 0, X sigma = 1)
-				: v(v), mu(mu), sigma(sigma == 0 ? 1 : sigma)
-			{ }
+				: v(v), mu(mu), sigma(sigma)
+			{
+				ensure(sigma != 0 and std::isfinite(sigma));
+			}
 			affine(const affine&) = default;
+			affine(affine&&) = default;
 			affine& operator=(const affine&) = default;
+			affine& operator=(affine&&) = default;
 			~affine()
 			{ }
 
+			const V& base() const
+			{
+				return v;
+			}
+			X location() const
+			{
+				return mu;
+			}
+			X scale() const
+			{
+				return sigma;
+			}
+
+			// P_s(mu + sigma X <= x) = P_{sigma s}(X <= (x - mu)/sigma) if sigma > 0
+			// and 1 - P_{sigma s}(X < (x - mu)/sigma) if sigma < 0
 			X cdf(X x, S s = 0, unsigned n = 0) const
 			{
-				return v.cdf((x - mu) / sigma, s, n) / pow(sigma, X(n));
+				X y = (x - mu) / sigma;
+				if (sigma < 0 and n == 0) {
+					return 1 - left(y, s);
+				}
+				X F = v.cdf(y, sigma * s, n);
+
+				return n == 0 ? F : (sigma < 0 ? -F : F) / pow(sigma, X(n));
+			}
+
+			void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+			{
+				ensure(out.size() >= x.size());
+
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = (x[i] - mu) / sigma;
+				}
+				if (sigma < 0 and n == 0) {
+					for (size_t i = 0; i < x.size(); ++i) {
+						out[i] = below(out[i]);
+					}
+				}
+				variate::cdf(v, std::span<const X>(out.data(), x.size()), sigma * s, n, out);
+				if (n != 0) {
+					X sigma_n = sigma < 0 ? -pow(sigma, X(n)) : pow(sigma, X(n));
+					for (size_t i = 0; i < x.size(); ++i) {
+						out[i] /= sigma_n;
+					}
+				}
+				else if (sigma < 0) {
+					for (size_t i = 0; i < x.size(); ++i) {
+						out[i] = 1 - out[i];
+					}
+				}
+			}
+
+			void cdf_jet(X x, S s, unsigned N, std::span<X> out) const
+			{
+				X y = (x - mu) / sigma;
+				variate::cdf_jet(v, y, sigma * s, N, out);
+
+				X sigma_n = sigma < 0 ? -1 : 1; // sign(sigma) sigma^n
+				for (unsigned n = 1; n <= N; ++n) {
+					sigma_n *= sigma;
+					out[n] /= sigma_n;
+				}
+				if (sigma < 0) {
+					out[0] = 1 - left(y, s);
+				}
 			}
 
 			S cumulant(S s, unsigned n = 0) const
@@ -59,12 +559,273 @@ Given a variate \(X\) construct the variate \(\mu + \sigma X\).
 				return v.cumulant(sigma * s, n) * pow(sigma, X(n)) + (n == 0 ? mu * s : n == 1 ? mu : 0);
 			}
 
+			// kappa(z) = mu z + kappa_X(sigma z)
+			std::complex<S> cumulant(std::complex<S> z) const
+				requires variate_cumulant_complex_concept<V>
+			{
+				return mu * z + v.cumulant(sigma * z);
+			}
+
+			void cumulant(std::span<const S> s, unsigned n, std::span<S> out) const
+			{
+				ensure(out.size() >= s.size());
+
+				std::vector<S> s_(s.begin(), s.end()); // s and out may alias
+				for (size_t i = 0; i < s.size(); ++i) {
+					out[i] = sigma * s_[i];
+				}
+				variate::cumulant(v, std::span<const S>(out.data(), s.size()), n, out);
+				X sigma_n = pow(sigma, X(n));
+				for (size_t i = 0; i < s.size(); ++i) {
+					out[i] = out[i] * sigma_n + (n == 0 ? mu * s_[i] : n == 1 ? mu : 0);
+				}
+			}
+
+			void cumulant_jet(S s, unsigned N, std::span<S> out) const
+			{
+				variate::cumulant_jet(v, sigma * s, N, out);
+
+				out[0] += mu * s;
+				X sigma_n = 1; // sigma^n
+				for (unsigned n = 1; n <= N; ++n) {
+					sigma_n *= sigma;
+					out[n] = out[n] * sigma_n + (n == 1 ? mu : 0);
+				}
+			}
+
+			// d/ds P_{sigma s}(X <= y) = sigma edf_X(sigma s, y) and d/ds (1 - P_{sigma s}(X < y)) = -sigma edf_X(sigma s, y-)
 			S edf(S s, X x) const
 			{
-				return sigma * v.edf(sigma * s, (x - mu)/sigma);
+				X y = (x - mu) / sigma;
+
+				return sigma < 0 ? -sigma * v.edf(sigma * s, below(y)) : sigma * v.edf(sigma * s, y);
+			}
+
+			void edf(S s, std::span<const X> x, std::span<X> out) const
+			{
+				ensure(out.size() >= x.size());
+
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = (x[i] - mu) / sigma;
+					if (sigma < 0) {
+						out[i] = below(out[i]);
+					}
+				}
+				variate::edf(v, sigma * s, std::span<const X>(out.data(), x.size()), out);
+				X abs_sigma = sigma < 0 ? -sigma : sigma;
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] *= abs_sigma;
+				}
+			}
+
+			X quantile(X p, S s = 0) const
+			{
+				return mu + sigma * (sigma < 0 ? reflect(p, s) : variate::quantile(v, p, sigma * s));
+			}
+
+			void quantile(std::span<const X> p, S s, std::span<X> out) const
+			{
+				if (sigma < 0) {
+					for (size_t i = 0; i < p.size(); ++i) {
+						out[i] = mu + sigma * reflect(p[i], s);
+					}
+
+					return;
+				}
+				variate::quantile(v, p, sigma * s, out);
+				for (size_t i = 0; i < p.size(); ++i) {
+					out[i] = mu + sigma * out[i];
+				}
+			}
+
+			template<std::uniform_random_bit_generator G>
+			void sample(G& g, std::span<X> out, S s = 0) const
+			{
+				variate::sample(v, g, out, sigma * s);
+				for (auto& x : out) {
+					x = mu + sigma * x;
+				}
+			}
+		};
+
+		template<class V>
+		struct is_affine : std::false_type {};
+		template<class V, class X, class S>
+		struct is_affine<affine<V, X, S>> : std::true_type {};
+
+		// mu + sigma v with nested affine transformations folded into one
+		template<variate_concept V, class X = typename V::xtype>
+		inline auto make_affine(const V& v, X mu, X sigma)
+		{
+			ensure(sigma != 0);
+
+			if constexpr (is_affine<V>::value) {
+				// mu + sigma(m + s X) = (mu + sigma m) + sigma s X
+				return make_affine(v.base(), mu + sigma * v.location(), sigma * v.scale());
+			}
+			else {
+				return affine<V>(v, mu, sigma);
+			}
+		}
+
+		// c * v
+		template<variate_concept V>
+		inline auto operator*(typename V::xtype c, const V& v)
+		{
+			return make_affine(v, typename V::xtype(0), c);
+		}
+		// v * c
+		template<variate_concept V>
+		inline auto operator*(const V& v, typename V::xtype c)
+		{
+			return make_affine(v, typename V::xtype(0), c);
+		}
+		// v / c
+		template<variate_concept V>
+		inline auto operator/(const V& v, typename V::xtype c)
+		{
+			return make_affine(v, typename V::xtype(0), 1 / c);
+		}
+		// v + c
+		template<variate_concept V>
+		inline auto operator+(const V& v, typename V::xtype c)
+		{
+			return make_affine(v, c, typename V::xtype(1));
+		}
+		// c + v
+		template<variate_concept V>
+		inline auto operator+(typename V::xtype c, const V& v)
+		{
+			return make_affine(v, c, typename V::xtype(1));
+		}
+		// v - c
+		template<variate_concept V>
+		inline auto operator-(const V& v, typename V::xtype c)
+		{
+			return make_affine(v, -c, typename V::xtype(1));
+		}
+		// c - v
+		template<variate_concept V>
+		inline auto operator-(typename V::xtype c, const V& v)
+		{
+			return make_affine(v, c, typename V::xtype(-1));
+		}
+		// -v
+		template<variate_concept V>
+		inline auto operator-(const V& v)
+		{
+			return make_affine(v, typename V::xtype(0), typename V::xtype(-1));
+		}
+
+		FMS_HELP(tilt) = R"(Esscher transformed variate X_s)";
+		FMS_DOC(tilt) = R"xyzyx(
+Given a variate \(X\) and \(s\) construct the variate \(Y = X_s\) with state that depends only on \(s\) computed once.
+The Esscher transform of \(Y\) is \(Y_t = X_{s + t}\) and its cumulant is \(\kappa_Y(t) = \kappa(s + t) - \kappa(s)\).
+Models can specialize <code>tilted</code> to cache more than \(\kappa(s)\).
+The transform of \(\mu + \sigma X\) is \(\mu + \sigma X_{\sigma s}\) and \((X_s)_t = X_{s + t}\).
+)xyzyx";
+		template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+		class tilted {
+			V v;
+			S s;
+			S kappa; // kappa(s)
+		public:
+			typedef X xtype;
+			typedef S stype;
+
+			tilted(const V& v, S s)
+				: v(v), s(s), kappa(v.cumulant(s))
+			{ }
+			tilted(const tilted&) = default;
+			tilted(tilted&&) = default;
+			tilted& operator=(const tilted&) = default;
+			tilted& operator=(tilted&&) = default;
+			~tilted()
+			{ }
+
+			const V& base() const
+			{
+				return v;
+			}
+			S parameter() const
+			{
+				return s;
+			}
+
+			X cdf(X x, S t = 0, unsigned n = 0) const
+			{
+				return v.cdf(x, s + t, n);
+			}
+			void cdf(std::span<const X> x, S t, unsigned n, std::span<X> out) const
+			{
+				variate::cdf(v, x, s + t, n, out);
+			}
+			void cdf_jet(X x, S t, unsigned N, std::span<X> out) const
+			{
+				variate::cdf_jet(v, x, s + t, N, out);
+			}
+
+			S cumulant(S t, unsigned n = 0) const
+			{
+				if (n == 0) {
+					return t == 0 ? 0 : v.cumulant(s + t) - kappa;
+				}
+
+				return v.cumulant(s + t, n);
+			}
+			void cumulant_jet(S t, unsigned N, std::span<S> out) const
+			{
+				variate::cumulant_jet(v, s + t, N, out);
+				out[0] -= kappa;
+			}
+
+			X edf(S t, X x) const
+			{
+				return v.edf(s + t, x);
+			}
+			void edf(S t, std::span<const X> x, std::span<X> out) const
+			{
+				variate::edf(v, s + t, x, out);
+			}
+
+			X quantile(X p, S t = 0) const
+			{
+				return variate::quantile(v, p, s + t);
+			}
+			void quantile(std::span<const X> p, S t, std::span<X> out) const
+			{
+				variate::quantile(v, p, s + t, out);
+			}
+
+			template<std::uniform_random_bit_generator G>
+			void sample(G& g, std::span<X> out, S t = 0) const
+			{
+				variate::sample(v, g, out, s + t);
 			}
 		};
 
+		template<class V>
+		struct is_tilted : std::false_type {};
+		template<class V, class X, class S>
+		struct is_tilted<tilted<V, X, S>> : std::true_type {};
+
+		// X_s with affine transformations and repeated tilts folded
+		template<variate_concept V>
+		inline auto tilt(const V& v, typename V::stype s)
+		{
+			if constexpr (is_affine<V>::value) {
+				// (mu + sigma X)_s = mu + sigma X_{sigma s}
+				return make_affine(tilt(v.base(), v.scale() * s), v.location(), v.scale());
+			}
+			else if constexpr (is_tilted<V>::value) {
+				// (X_s)_t = X_{s + t}
+				return tilt(v.base(), v.parameter() + s);
+			}
+			else {
+				return tilted<V>(v, s);
+			}
+		}
+
 		FMS_DOC(cdf) = R"xyzyx(
 Returns the \(n\)-th derivative of the Esscher transformed cumulative distrubution.
 The <em>Esscher transform</em> of the density function \(f\) of a random variable \(X\) is 
@@ -83,7 +844,7 @@ Return the \(n\)-th derivative of the cumulant \(\kappa(s) = \log(E[e^{sX}]).
 		template<variate_concept V, class S = typename V::stype>
 		inline S cumulant(const V& v, S s, unsigned n = 0)
 		{
-			return v.cumlant(s, n);
+			return v.cumulant(s, n);
 		}
 
 		FMS_DOC(edf) = R"xyzyx(
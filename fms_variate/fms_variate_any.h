@@ -0,0 +1,109 @@
+// fms_variate_any.h - closed set of variates dispatched without virtual calls
+#pragma once
+#include <complex>
+#include <random>
+#include <span>
+#include <variant>
+#include "fms_variate.h"
+#include "fms_variate_constant.h"
+#include "fms_variate_discrete.h"
+#include "fms_variate_logistic.h"
+#include "fms_variate_normal.h"
+
+namespace fms::variate {
+
+	// mu + sigma V where V is one of the models below stored inline.
+	// Calls go through std::visit so each alternative is a direct call the compiler can inline.
+	template<class X = double, class S = X>
+	class variate_any {
+	public:
+		typedef X xtype;
+		typedef S stype;
+		typedef std::variant<affine<standard_normal<X, S>>, affine<logistic<X, S>>,
+			affine<constant<X, S>>, affine<discrete<X, S>>> model;
+		// V is one of the models
+		template<class V>
+		static constexpr bool alternative = std::is_same_v<V, standard_normal<X, S>> or std::is_same_v<V, logistic<X, S>>
+			or std::is_same_v<V, constant<X, S>> or std::is_same_v<V, discrete<X, S>>;
+	private:
+		model m;
+
+		template<class F>
+		decltype(auto) visit(F&& f) const
+		{
+			return std::visit(std::forward<F>(f), m);
+		}
+	public:
+		template<class V>
+			requires alternative<V>
+		variate_any(const V& v, X mu = 0, X sigma = 1)
+			: m(affine<V>(v, mu, sigma))
+		{ }
+		template<class V>
+			requires alternative<V>
+		variate_any(const affine<V>& a)
+			: m(a)
+		{ }
+
+		// underlying model
+		const model& get() const
+		{
+			return m;
+		}
+
+		X cdf(X x, S s = 0, unsigned n = 0) const
+		{
+			return visit([=](const auto& v) { return v.cdf(x, s, n); });
+		}
+		void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+		{
+			visit([=](const auto& v) { variate::cdf(v, x, s, n, out); });
+		}
+		void cdf_jet(X x, S s, unsigned N, std::span<X> out) const
+		{
+			visit([=](const auto& v) { variate::cdf_jet(v, x, s, N, out); });
+		}
+
+		S cumulant(S s, unsigned n = 0) const
+		{
+			return visit([=](const auto& v) { return v.cumulant(s, n); });
+		}
+		std::complex<S> cumulant(std::complex<S> z) const
+		{
+			return visit([=](const auto& v) { return v.cumulant(z); });
+		}
+		void cumulant(std::span<const S> s, unsigned n, std::span<S> out) const
+		{
+			visit([=](const auto& v) { variate::cumulant(v, s, n, out); });
+		}
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			visit([=](const auto& v) { variate::cumulant_jet(v, s, N, out); });
+		}
+
+		X edf(S s, X x) const
+		{
+			return visit([=](const auto& v) { return v.edf(s, x); });
+		}
+		void edf(S s, std::span<const X> x, std::span<X> out) const
+		{
+			visit([=](const auto& v) { variate::edf(v, s, x, out); });
+		}
+
+		X quantile(X p, S s = 0) const
+		{
+			return visit([=](const auto& v) { return v.quantile(p, s); });
+		}
+		void quantile(std::span<const X> p, S s, std::span<X> out) const
+		{
+			visit([=](const auto& v) { v.quantile(p, s, out); });
+		}
+
+		template<std::uniform_random_bit_generator G>
+		void sample(G& g, std::span<X> out, S s = 0) const
+		{
+			visit([&](const auto& v) { v.sample(g, out, s); });
+		}
+	};
+
+}
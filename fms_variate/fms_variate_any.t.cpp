@@ -0,0 +1,152 @@
+// fms_variate_any.t.cpp - test variant dispatch against the models and the vtable handle
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+#include "fms_variate_any.h"
+#include "fms_variate_handle.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<variate_any<>>);
+static_assert(variate_batch_concept<variate_any<>>);
+static_assert(variate_quantile_batch_concept<variate_any<>>);
+static_assert(variate_cumulant_jet_concept<variate_any<>>);
+static_assert(variate_sample_concept<variate_any<>, random::philox>);
+static_assert(std::is_nothrow_move_constructible_v<variate_any<>>);
+
+// variate_any(v, mu, sigma) is the same as affine(v, mu, sigma)
+template<class V, class X = typename V::xtype>
+inline void test_variate_any_same(const V& v, X mu, X sigma)
+{
+	affine A(v, mu, sigma);
+	variate_any<X> Y(v, mu, sigma);
+	variate_handle<variate_any<X>> H(Y);
+	const variate_base<X>& B = H;
+
+	std::vector<X> x = { X(-2), X(-0.5), X(0.5), X(1), X(3) };
+	std::vector<X> out(x.size()), out_(x.size());
+	for (X s : { X(-0.2), X(0), X(0.3) }) {
+		for (X xi : x) {
+			assert(Y.cdf(xi, s) == A.cdf(xi, s));
+			assert(Y.cdf(xi, s, 1) == A.cdf(xi, s, 1));
+			assert(Y.edf(s, xi) == A.edf(s, xi));
+			assert(B.cdf(xi, s) == A.cdf(xi, s));
+		}
+		assert(Y.cumulant(s, 2) == A.cumulant(s, 2));
+		assert(Y.cumulant(std::complex<X>(s, 1)) == A.cumulant(std::complex<X>(s, 1)));
+		assert(Y.quantile(X(0.3), s) == A.quantile(X(0.3), s));
+
+		Y.cdf(x, s, 0, out);
+		A.cdf(x, s, 0, out_);
+		assert(out == out_);
+		Y.edf(s, x, out);
+		A.edf(s, x, out_);
+		assert(out == out_);
+	}
+}
+
+template<class X>
+int test_variate_any()
+{
+	X xi[] = { X(-1), X(0.5), X(2) };
+	X pi[] = { X(0.2), X(0.5), X(0.3) };
+
+	test_variate_any_same(standard_normal<X>{}, X(1), X(2));
+	test_variate_any_same(logistic<X>(2, 3), X(-1), X(0.5));
+	test_variate_any_same(logistic<X>(2, 3), X(1), X(-2));
+	test_variate_any_same(constant<X>(X(0.5)), X(0), X(1));
+	test_variate_any_same(discrete<X>(xi, pi), X(1), X(3));
+
+	{
+		// value semantics
+		variate_any<X> Y(standard_normal<X>{});
+		assert(std::holds_alternative<affine<standard_normal<X>>>(Y.get()));
+		Y = variate_any<X>(discrete<X>(xi, pi), 1);
+		assert(std::holds_alternative<affine<discrete<X>>>(Y.get()));
+		assert(Y.cdf(X(1)) == X(0.2));
+		// moves do not copy the atoms
+		const X* a = std::get<affine<discrete<X>>>(Y.get()).base().atoms().data();
+		variate_any<X> Z(std::move(Y));
+		assert(std::get<affine<discrete<X>>>(Z.get()).base().atoms().data() == a);
+		Y = std::move(Z);
+		assert(std::get<affine<discrete<X>>>(Y.get()).base().atoms().data() == a);
+		std::vector<variate_any<X>> v = { Y, variate_any<X>(logistic<X>()) };
+		assert(v[0].cdf(X(1)) == X(0.2));
+		assert(fabs(v[1].cdf(X(0)) - X(0.5)) < 1e-15);
+	}
+
+	return 0;
+}
+int test_variate_any_d = test_variate_any<double>();
+
+// variant dispatch compared to the vtable over the same model
+// Returns the ratios of the variant to the vtable time for scalar and batch calls.
+template<class V>
+inline std::pair<double, double> benchmark_variate_any(const V& v, const std::vector<double>& x, int reps)
+{
+	std::vector<double> out(x.size());
+	variate_any<> Y(v, 0.1, 2);
+	std::unique_ptr<variate_base<>> B(new variate_handle(affine(v, 0.1, 2.)));
+	double sum = 0;
+
+	auto scalar = [&](const auto& w) {
+		return test::time([&]() {
+			for (int k = 0; k < reps; ++k) {
+				for (size_t i = 0; i < x.size(); ++i) {
+					sum += w.cdf(x[i], 0.1);
+				}
+			}
+		});
+	};
+	auto batch = [&](const auto& w) {
+		return test::time([&]() {
+			for (int k = 0; k < reps; ++k) {
+				for (size_t i = 0; i < x.size(); i += 16) {
+					w.cdf(std::span<const double>(x).subspan(i, 16), 0.1, 0, std::span<double>(out).subspan(i, 16));
+				}
+			}
+		});
+	};
+	// fastest of alternating trials after a warm up
+	scalar(Y);
+	double ms_any = 1e9, ms_base = 1e9, ms_any_batch = 1e9, ms_base_batch = 1e9;
+	for (int trial = 0; trial < 5; ++trial) {
+		ms_any = std::min(ms_any, scalar(Y));
+		ms_base = std::min(ms_base, scalar(*B));
+		ms_any_batch = std::min(ms_any_batch, batch(Y));
+		ms_base_batch = std::min(ms_base_batch, batch(*B));
+	}
+	assert(sum != 0);
+
+	return { ms_any / ms_base, ms_any_batch / ms_base_batch };
+}
+int benchmark_variate_any()
+{
+	random::philox g(7);
+	std::vector<double> x(1 << 14);
+	for (auto& xi : x) {
+		xi = random::normal(g);
+	}
+
+	// dispatch cost is visible next to the normal cdf
+	auto [normal, normal_batch] = benchmark_variate_any(standard_normal<>{}, x, 100);
+	test::report("variate_any/vtable normal", normal);
+	test::report("variate_any/vtable normal batch", normal_batch);
+	assert(normal < 100 and normal_batch < 100); // not horrible
+	// and buried under beta_inc for the logistic
+	auto [logistic_, logistic_batch] = benchmark_variate_any(logistic<>(2, 3), x, 2);
+	test::report("variate_any/vtable logistic", logistic_);
+	test::report("variate_any/vtable logistic batch", logistic_batch);
+	assert(logistic_ < 100 and logistic_batch < 100); // not horrible
+
+	return 0;
+}
+int benchmark_variate_any_ = benchmark_variate_any();
@@ -0,0 +1,105 @@
+// fms_variate_cache.h - small cache of per s state shared by copies of a variate
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace fms::variate {
+
+	// Immutable values T built for up to M distinct s, keyed on T::s.
+	// The least recently used entry is replaced on a miss. Lookups never lock and a hit
+	// only writes if its entry has not been used since the last miss.
+	// Copies share the entries and a copy or move is cheap.
+	template<class T, size_t M = 4>
+		requires (M >= 1)
+	class s_cache {
+		struct slot {
+			std::atomic<std::shared_ptr<const T>> t;
+			std::atomic<uint64_t> used{ 0 }; // clock at last use
+		};
+		slot slots[M];
+		std::atomic<uint64_t> clock{ 0 }; // number of misses
+
+		void assign(const s_cache& c)
+		{
+			for (size_t i = 0; i < M; ++i) {
+				slots[i].t.store(c.slots[i].t.load());
+				slots[i].used.store(c.slots[i].used.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+			clock.store(c.clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		void assign(s_cache&& c) noexcept
+		{
+			for (size_t i = 0; i < M; ++i) {
+				slots[i].t.store(c.slots[i].t.exchange(nullptr));
+				slots[i].used.store(c.slots[i].used.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+			clock.store(c.clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	public:
+		s_cache()
+		{ }
+		s_cache(const s_cache& c)
+		{
+			assign(c);
+		}
+		s_cache(s_cache&& c) noexcept
+		{
+			assign(std::move(c));
+		}
+		s_cache& operator=(const s_cache& c)
+		{
+			if (this != &c) {
+				assign(c);
+			}
+
+			return *this;
+		}
+		s_cache& operator=(s_cache&& c) noexcept
+		{
+			if (this != &c) {
+				assign(std::move(c));
+			}
+
+			return *this;
+		}
+		~s_cache()
+		{ }
+
+		// cached value for s or build(s) if none
+		template<class S, class F>
+		std::shared_ptr<const T> at(S s, const F& build)
+		{
+			uint64_t now = clock.load(std::memory_order_relaxed);
+			for (auto& e : slots) {
+				auto t = e.t.load(std::memory_order_acquire);
+				if (t and t->s == s) {
+					if (e.used.load(std::memory_order_relaxed) != now) {
+						e.used.store(now, std::memory_order_relaxed);
+					}
+
+					return t;
+				}
+			}
+
+			std::shared_ptr<const T> t = build(s);
+			now = clock.fetch_add(1, std::memory_order_relaxed) + 1;
+			slot* lru = &slots[0];
+			for (auto& e : slots) {
+				if (e.used.load(std::memory_order_relaxed) < lru->used.load(std::memory_order_relaxed)) {
+					lru = &e;
+				}
+			}
+			lru->t.store(t, std::memory_order_release);
+			lru->used.store(now, std::memory_order_relaxed);
+
+			return t;
+		}
+		// number of values built
+		uint64_t misses() const
+		{
+			return clock.load(std::memory_order_relaxed);
+		}
+	};
+
+}
@@ -0,0 +1,450 @@
+// fms_variate_chebyshev.h - piecewise Chebyshev approximation of a variate
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_sf_simd.h"
+#include "fms_variate.h"
+
+namespace fms::variate {
+
+	static inline const char chebyshev_doc[] = R"xyzyx(
+Approximate the cdf \(F_s\), density \(F_s'\), and \(\partial F_s/\partial s\) of a variate on \([l, h]\)
+for a fixed set of \(s\) values by Chebyshev series of degree \(d\) on \(m\) equal pieces.
+The number of pieces is doubled until the largest absolute error at points between the
+Chebyshev nodes is below the tolerance for all three functions.
+Outside \([l, h]\) the hazard rate \(\eta = F'/F\) below \(l\), or \(F'/(1 - F)\) above \(h\), is extended
+linearly from its value and slope at the end. The slope is computed from \(F\), \(F'\), and \(F''\),
+so \(\log F\) is quadratic in the distance past the end. This is exact for exponential tails and
+follows the Mills ratio \(\eta(x) \approx |x|\) for normal tails.
+The ratio of \(\partial F_s/\partial s\) to the tail probability is extended linearly using
+\(\partial^2 F_s/\partial s\partial x = (x - \kappa'(s))F_s'(x)\).
+The largest relative error of the tails a sixteenth of \(h - l\) to a quarter past each end is
+reported separately from the absolute error on \([l, h]\).
+Evaluation is a piece lookup and a Clenshaw recurrence with no calls to the original variate.
+)xyzyx";
+	template<class X = double, class S = X>
+	class chebyshev {
+		static constexpr int F = 0, f = 1, E = 2; // cdf, pdf, edf
+		static constexpr unsigned max_pieces = 1 << 12;
+
+		struct table {
+			S s;
+			S kappa[5]; // kappa(s), ..., kappa''''(s)
+			X lo, w; // left end and width of pieces
+			unsigned m; // number of pieces
+			std::vector<X> c[3]; // d + 1 coefficients per piece, c_0 halved
+			// z + e^{c1 t + c2 t^2}(a + b t) where t is the distance past the end
+			struct tail {
+				X c1, c2;
+				X z[3], a[3], b[3];
+			} lower, upper;
+		};
+		unsigned d; // degree
+		X tol, err, tail_err;
+		std::vector<table> t;
+
+		// table fitted at s
+		const table& at(S s) const
+		{
+			auto i = std::find_if(t.begin(), t.end(), [s](const table& ti) { return ti.s == s; });
+			ensure(i != t.end());
+
+			return *i;
+		}
+
+		// sum_j c_j T_j(u) using Clenshaw
+		static X clenshaw(const X* c, unsigned d, X u)
+		{
+			X b1 = 0, b2 = 0;
+			for (unsigned j = d; j > 0; --j) {
+				X b0 = 2 * u * b1 - b2 + c[j];
+				b2 = b1;
+				b1 = b0;
+			}
+
+			return u * b1 - b2 + c[0];
+		}
+
+		// piece and Chebyshev variable for x in [lo, hi]
+		static size_t piece(const table& T, X x, X& u)
+		{
+			X y = (x - T.lo) / T.w;
+			X k = std::min(std::max(std::floor(y), X(0)), X(T.m - 1));
+			u = 2 * (y - k) - 1;
+
+			return static_cast<size_t>(k);
+		}
+
+		// function g of tail T at distance t past the end
+		static X value(const typename table::tail& T, int g, X t)
+		{
+			return T.z[g] + exp(T.c1 * t + T.c2 * t * t) * (T.a[g] + T.b[g] * t);
+		}
+		// n-th derivative of the density of tail T at t
+		static X derivative(const typename table::tail& T, X t, unsigned n)
+		{
+			// d/dt e^P q = e^P (P' q + q') with P' = c1 + 2 c2 t
+			std::vector<X> q = { T.a[f], T.b[f] };
+			for (unsigned j = 0; j < n; ++j) {
+				std::vector<X> dq(q.size() + 1, X(0));
+				for (size_t i = 0; i < q.size(); ++i) {
+					dq[i] += T.c1 * q[i];
+					dq[i + 1] += 2 * T.c2 * q[i];
+					if (i > 0) {
+						dq[i - 1] += X(i) * q[i];
+					}
+				}
+				q.swap(dq);
+			}
+			X p = 0;
+			for (size_t i = q.size(); i-- > 0; ) {
+				p = p * t + q[i];
+			}
+
+			return p * exp(T.c1 * t + T.c2 * t * t);
+		}
+
+		// function g of table T at x
+		X value(const table& T, int g, X x) const
+		{
+			if (x < T.lo) {
+				return value(T.lower, g, x - T.lo);
+			}
+			X hi = T.lo + T.m * T.w;
+			if (hi < x) {
+				return value(T.upper, g, x - hi);
+			}
+			X u;
+			size_t k = piece(T, x, u);
+
+			return clenshaw(T.c[g].data() + k * (d + 1), d, u);
+		}
+
+		// function g of table T at lanes x
+		template<class V>
+		V value(const table& T, int g, V x) const
+		{
+			const double* c = T.c[g].data();
+			V lo(T.lo), hi(T.lo + T.m * T.w);
+			V y = (x - lo) / V(T.w);
+			V k = min(max(floor(y), V(0)), V(T.m - 1));
+			V u = V(2) * (y - k) - V(1);
+			V i = k * V(d + 1);
+
+			V b1(0), b2(0);
+			for (unsigned j = d; j > 0; --j) {
+				V b0 = fma(V(2) * u, b1, gather(c + j, i) - b2);
+				b2 = b1;
+				b1 = b0;
+			}
+			V p = fma(u, b1, gather(c, i) - b2);
+
+			auto tail = [g](const typename table::tail& T, V t) {
+				V e = sf::lane::exp(fma(V(T.c2) * t, t, V(T.c1) * t));
+
+				return fma(e, fma(V(T.b[g]), t, V(T.a[g])), V(T.z[g]));
+			};
+			V l = tail(T.lower, min(x - lo, V(0)));
+			V h = tail(T.upper, max(x - hi, V(0)));
+
+			return select(x < lo, l, select(hi < x, h, p));
+		}
+
+		// fit g on m pieces and return the largest error at points between the nodes
+		template<class G>
+		X fit(table& T, int g, const G& v) const
+		{
+			unsigned n = d + 1;
+			std::vector<X> x(T.m * n), y(x.size());
+			for (unsigned k = 0; k < T.m; ++k) {
+				for (unsigned j = 0; j < n; ++j) {
+					X u = cos(std::numbers::pi_v<X> * (j + X(0.5)) / n);
+					x[k * n + j] = T.lo + T.w * (k + (u + 1) / 2);
+				}
+			}
+			v(x, y);
+
+			auto& c = T.c[g];
+			c.assign(T.m * n, X(0));
+			for (unsigned k = 0; k < T.m; ++k) {
+				for (unsigned i = 0; i < n; ++i) {
+					X ci = 0;
+					for (unsigned j = 0; j < n; ++j) {
+						ci += y[k * n + j] * cos(std::numbers::pi_v<X> * i * (j + X(0.5)) / n);
+					}
+					c[k * n + i] = 2 * ci / n;
+				}
+				c[k * n] /= 2;
+			}
+
+			// extrema of T_n between the nodes and the right end of each piece
+			for (unsigned k = 0; k < T.m; ++k) {
+				for (unsigned j = 0; j < n; ++j) {
+					X u = cos(std::numbers::pi_v<X> * j / n);
+					x[k * n + j] = T.lo + T.w * (k + (u + 1) / 2);
+				}
+			}
+			v(x, y);
+			X e = 0;
+			for (size_t i = 0; i < x.size(); ++i) {
+				X u;
+				size_t k = piece(T, x[i], u);
+				e = std::max(e, fabs(clenshaw(c.data() + k * n, d, u) - y[i]));
+			}
+
+			return e;
+		}
+
+		// hazard rate eta and its slope at each end and the edf ratio r and its slope
+		template<variate_concept V>
+		static void fit_tails(table& T, const V& v, X hi)
+		{
+			S s = T.s;
+			X k1 = X(T.kappa[1]);
+
+			// P(X <= lo + t) = F e^{eta t - eta' t^2/2}, eta' = eta^2 - F''/F
+			auto& L = T.lower;
+			X F_ = v.cdf(T.lo, s), f_ = v.cdf(T.lo, s, 1), df = v.cdf(T.lo, s, 2), E_ = v.edf(s, T.lo);
+			L = {};
+			if (F_ > 0) {
+				X eta = f_ / F_;
+				X deta = std::max(eta * eta - df / F_, X(0));
+				X r = E_ / F_; // r' = eta(x - kappa' - r)
+				L.c1 = eta;
+				L.c2 = -deta / 2;
+				L.a[F] = F_;
+				L.a[f] = f_;
+				L.b[f] = -F_ * deta;
+				L.a[E] = E_;
+				L.b[E] = F_ * eta * (T.lo - k1 - r);
+			}
+
+			// P(X > hi + t) = G e^{-eta t - eta' t^2/2}, eta' = eta^2 + F''/G
+			auto& U = T.upper;
+			X G = 1 - v.cdf(hi, s);
+			f_ = v.cdf(hi, s, 1);
+			df = v.cdf(hi, s, 2);
+			E_ = v.edf(s, hi);
+			// 1 - F has absolute error eps so use the asymptotic series of m = G/f in l = -f'/f if that is smaller
+			// m = 1/l - l'/l^3 + (3l'^2 - l l'')/l^5 - ...
+			X m = 0;
+			if (f_ > 0 and df < 0) {
+				X d2f = v.cdf(hi, s, 3), d3f = v.cdf(hi, s, 4);
+				X g1 = df / f_, g2 = d2f / f_, g3 = d3f / f_;
+				X l = -g1;
+				X dl = g1 * g1 - g2;
+				X ddl = -(g3 - 3 * g1 * g2 + 2 * g1 * g1 * g1);
+				X q = dl / (l * l), q2 = (3 * dl * dl - l * ddl) / (l * l * l * l);
+				if (fabs(q) < X(0.5) and fabs(q * q2) * G < std::numeric_limits<X>::epsilon()) {
+					m = (1 - q + q2) / l;
+					G = f_ * m;
+				}
+			}
+			U = {};
+			U.z[F] = 1;
+			if (G > 0) {
+				X eta = f_ / G;
+				X deta = std::max(eta * eta + df / G, X(0));
+				if (m > 0) {
+					// eta = 1/m and m' = l m - 1 avoid cancellation
+					deta = std::max((1 + m * df / f_) / (m * m), X(0));
+					// E = -(hi - kappa')G - int_hi^infty G
+					E_ = -G * (hi - k1 + (1 - deta / (eta * eta)) / eta);
+				}
+				X r = E_ / G; // r' = eta(x - kappa' + r)
+				U.c1 = -eta;
+				U.c2 = -deta / 2;
+				U.a[F] = -G;
+				U.a[f] = f_;
+				U.b[f] = G * deta;
+				U.a[E] = E_;
+				U.b[E] = G * eta * (hi - k1 + r);
+			}
+		}
+		// largest relative error of the tails up to a quarter of the interval past each end
+		template<variate_concept V>
+		X tail_fit(const table& T, const V& v, X hi) const
+		{
+			static constexpr X eps = std::numeric_limits<X>::epsilon();
+			auto rel = [](X y, X y_) {
+				return std::isnormal(y_) ? fabs(y - y_) / fabs(y_) : X(0);
+			};
+
+			X e = 0, h = (hi - T.lo) / 16;
+			for (int j = 1; j <= 4; ++j) {
+				X x = T.lo - j * h;
+				e = std::max(e, rel(value(T, F, x), v.cdf(x, T.s)));
+				e = std::max(e, rel(value(T, f, x), v.cdf(x, T.s, 1)));
+				e = std::max(e, rel(value(T, E, x), v.edf(T.s, x)));
+
+				// 1 - F and its s derivative have absolute error eps in the upper tail
+				x = hi + j * h;
+				X G = 1 - v.cdf(x, T.s), E_ = v.edf(T.s, x);
+				if (G > sqrt(eps)) {
+					e = std::max(e, rel(1 - value(T, F, x), G));
+				}
+				if (fabs(E_) > sqrt(eps)) {
+					e = std::max(e, rel(value(T, E, x), E_));
+				}
+				e = std::max(e, rel(value(T, f, x), v.cdf(x, T.s, 1)));
+			}
+
+			return e;
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// fit v on [lo, hi] for each s to absolute tolerance tol using degree d
+		template<variate_concept V>
+		chebyshev(const V& v, X lo, X hi, std::span<const S> s, X tol = X(1e-12), unsigned d = 12)
+			: d(d), tol(tol), err(0), tail_err(0)
+		{
+			ensure(lo < hi);
+			ensure(s.size() > 0);
+			ensure(tol > 0);
+			ensure(d >= 2);
+
+			for (S si : s) {
+				table T;
+				T.s = si;
+				variate::cumulant_jet(v, si, 4, std::span<S>(T.kappa));
+				T.lo = lo;
+
+				X e = 0;
+				for (T.m = 4; T.m <= max_pieces; T.m *= 2) {
+					T.w = (hi - lo) / T.m;
+					e = fit(T, F, [&](std::span<const X> x, std::span<X> y) { variate::cdf(v, x, si, 0, y); });
+					e = std::max(e, fit(T, f, [&](std::span<const X> x, std::span<X> y) { variate::cdf(v, x, si, 1, y); }));
+					e = std::max(e, fit(T, E, [&](std::span<const X> x, std::span<X> y) { variate::edf(v, si, x, y); }));
+					if (e <= tol) {
+						break;
+					}
+				}
+				T.m = std::min(T.m, max_pieces);
+				T.w = (hi - lo) / T.m;
+				err = std::max(err, e);
+
+				// tails from the values of v at the ends
+				fit_tails(T, v, hi);
+				tail_err = std::max(tail_err, tail_fit(T, v, hi));
+
+				t.push_back(std::move(T));
+			}
+		}
+		template<variate_concept V>
+		chebyshev(const V& v, X lo, X hi, S s = 0, X tol = X(1e-12), unsigned d = 12)
+			: chebyshev(v, lo, hi, std::span<const S>(&s, 1), tol, d)
+		{ }
+		chebyshev(const chebyshev&) = default;
+		chebyshev& operator=(const chebyshev&) = default;
+		~chebyshev()
+		{ }
+
+		// largest absolute error on [lo, hi] measured while fitting
+		X error() const
+		{
+			return err;
+		}
+		// largest relative error of the tails measured while fitting
+		X tail_error() const
+		{
+			return tail_err;
+		}
+		// true if every fit on [lo, hi] met the tolerance
+		bool converged() const
+		{
+			return err <= tol;
+		}
+		// number of pieces used for s
+		unsigned pieces(S s) const
+		{
+			return at(s).m;
+		}
+
+		// n > 1 differentiates the density series
+		X cdf(X x, S s = 0, unsigned n = 0) const
+		{
+			const table& T = at(s);
+
+			if (n <= 1) {
+				return value(T, n == 0 ? F : f, x);
+			}
+
+			X hi = T.lo + T.m * T.w;
+			if (x < T.lo) {
+				return derivative(T.lower, x - T.lo, n - 1);
+			}
+			if (hi < x) {
+				return derivative(T.upper, x - hi, n - 1);
+			}
+
+			// coefficients of the (n - 1)-th derivative in u
+			X u;
+			size_t k = piece(T, x, u);
+			std::vector<X> c(T.c[f].begin() + k * (d + 1), T.c[f].begin() + (k + 1) * (d + 1));
+			c[0] *= 2;
+			for (unsigned j = 1; j < n; ++j) {
+				std::vector<X> dc(d + 1, X(0));
+				for (unsigned i = d; i-- > 0; ) {
+					dc[i] = (i + 2 <= d ? dc[i + 2] : 0) + 2 * (i + 1) * c[i + 1];
+				}
+				c.swap(dc);
+			}
+			c[0] /= 2;
+
+			return clenshaw(c.data(), d, u) * pow(2 / T.w, X(n - 1));
+		}
+		// out[i] = cdf(x[i], s, n), x and out may alias
+		void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+		{
+			ensure(out.size() >= x.size());
+			const table& T = at(s);
+
+			if constexpr (std::is_same_v<X, double>) {
+				if (n <= 1) {
+					int g = n == 0 ? F : f;
+					simd::transform(x, out, [this, &T, g](auto x) { return value(T, g, x); });
+
+					return;
+				}
+			}
+			for (size_t i = 0; i < x.size(); ++i) {
+				out[i] = cdf(x[i], s, n);
+			}
+		}
+
+		S cumulant(S s, unsigned n = 0) const
+		{
+			ensure(n <= 4);
+
+			return at(s).kappa[n];
+		}
+
+		X edf(S s, X x) const
+		{
+			return value(at(s), E, x);
+		}
+		void edf(S s, std::span<const X> x, std::span<X> out) const
+		{
+			ensure(out.size() >= x.size());
+			const table& T = at(s);
+
+			if constexpr (std::is_same_v<X, double>) {
+				simd::transform(x, out, [this, &T](auto x) { return value(T, E, x); });
+			}
+			else {
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = value(T, E, x[i]);
+				}
+			}
+		}
+	};
+
+}
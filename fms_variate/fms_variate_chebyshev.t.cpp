@@ -0,0 +1,135 @@
+// fms_variate_chebyshev.t.cpp - test piecewise Chebyshev variate
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+#include "fms_variate_chebyshev.h"
+#include "fms_variate_handle.h"
+#include "fms_variate_logistic.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<chebyshev<>>);
+static_assert(variate_batch_concept<chebyshev<>>);
+static_assert(variate_edf_batch_concept<chebyshev<>>);
+
+template<class X>
+int test_variate_chebyshev()
+{
+	random::philox g(11);
+	{
+		logistic<X> v(2, X(1.5));
+		X s[] = { X(0), X(0.5) };
+		X tol = X(1e-11);
+		chebyshev<X> C(v, -30, 30, s, tol);
+		assert(C.converged());
+		// relative to the finite difference edf of v
+		assert(C.error() <= tol);
+		assert(C.tail_error() < 1e-6);
+		for (X si : s) {
+			assert(C.pieces(si) <= 1024);
+			for (unsigned n = 0; n <= 4; ++n) {
+				assert(fabs(C.cumulant(si, n) - v.cumulant(si, n)) < 1e-13 * std::max(X(1), fabs(v.cumulant(si, n))));
+			}
+			for (int i = 0; i < 1000; ++i) {
+				X x = X(-30 + 60 * random::uniform(g));
+				assert(fabs(C.cdf(x, si) - v.cdf(x, si)) < 10 * tol);
+				assert(fabs(C.cdf(x, si, 1) - v.cdf(x, si, 1)) < 10 * tol);
+				assert(fabs(C.edf(si, x) - v.edf(si, x)) < 10 * tol);
+			}
+			for (X x : { X(-3), X(0), X(2) }) {
+				assert(fabs(C.cdf(x, si, 2) - v.cdf(x, si, 2)) < 1e-8);
+				assert(fabs(C.cdf(x, si, 3) - v.cdf(x, si, 3)) < 1e-6);
+			}
+			// exponential tails
+			for (X x : { X(-40), X(-31), X(31), X(40) }) {
+				assert(fabs(C.cdf(x, si) - v.cdf(x, si)) < 1e-13);
+				assert(fabs(C.cdf(x, si, 1) - v.cdf(x, si, 1)) < 1e-13);
+				assert(fabs(C.cdf(x, si, 2) - v.cdf(x, si, 2)) < 1e-13);
+			}
+		}
+
+		// batch is the same as scalar
+		std::vector<X> x(1001), y(x.size()), z(x.size());
+		for (size_t i = 0; i < x.size(); ++i) {
+			x[i] = X(-40 + 80 * X(i) / (x.size() - 1));
+		}
+		for (unsigned n = 0; n <= 2; ++n) {
+			C.cdf(x, s[1], n, y);
+			for (size_t i = 0; i < x.size(); ++i) {
+				assert(fabs(y[i] - C.cdf(x[i], s[1], n)) < 1e-14);
+			}
+		}
+		C.edf(s[1], x, z);
+		for (size_t i = 0; i < x.size(); ++i) {
+			assert(fabs(z[i] - C.edf(s[1], x[i])) < 1e-14);
+		}
+
+		// only the fitted s
+		bool thrown = false;
+		try {
+			C.cdf(0, X(0.25));
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		assert(thrown);
+
+		// drops into the handle
+		std::unique_ptr<variate_base<X>> h(new variate_handle(C));
+		assert(h->cdf(X(1), X(0.5)) == C.cdf(X(1), X(0.5)));
+		X q = h->quantile(X(0.3), X(0.5));
+		assert(fabs(v.cdf(q, X(0.5)) - X(0.3)) < 10 * tol);
+	}
+	{
+		standard_normal<X> N;
+		chebyshev<X> C(N, -10, 10, X(0.2), X(1e-13), 16);
+		assert(C.converged());
+		for (X x = -12; x <= 12; x += X(0.01)) {
+			assert(fabs(C.cdf(x, X(0.2)) - N.cdf(x, X(0.2))) < 1e-12);
+			assert(fabs(C.cdf(x, X(0.2), 1) - N.cdf(x, X(0.2), 1)) < 1e-12);
+		}
+	}
+	{
+		// Mills ratio tails have small relative error past the ends
+		standard_normal<X> N;
+		chebyshev<X> C(N, -6, 6, X(0));
+		assert(C.converged());
+		for (X x : { X(7), X(8) }) {
+			assert(fabs(C.cdf(-x) / N.cdf(-x) - 1) < 0.01);
+			assert(fabs(C.cdf(-x, 0, 1) / N.cdf(-x, 0, 1) - 1) < 0.01);
+			assert(fabs(C.cdf(x, 0, 1) / N.cdf(x, 0, 1) - 1) < 0.01);
+			assert(fabs(C.edf(0, -x) / N.edf(0, -x) - 1) < 0.01);
+		}
+		// 1 - F(8) is below the resolution of F
+		assert(fabs((1 - C.cdf(7)) / N.cdf(-7) - 1) < 0.01);
+		assert(C.error() <= 1e-12);
+		assert(C.tail_error() < 0.05);
+	}
+
+	return 0;
+}
+int test_variate_chebyshev_d = test_variate_chebyshev<double>();
+
+// batch cdf of the fit and the model
+int benchmark_variate_chebyshev()
+{
+	logistic<> v(2, 1.5);
+	chebyshev<> C(v, -30, 30, 0.1);
+	std::vector<double> x(1 << 16), y(x.size());
+	for (size_t i = 0; i < x.size(); ++i) {
+		x[i] = -20 + 40 * double(i) / x.size();
+	}
+
+	double ms_model = test::time([&]() { v.cdf(x, 0.1, 0, y); });
+	double ms_fit = test::time([&]() { C.cdf(x, 0.1, 0, y); });
+	assert(ms_fit < ms_model); // not horrible
+
+	return 0;
+}
+int benchmark_variate_chebyshev_ = benchmark_variate_chebyshev();
@@ -1,7 +1,10 @@
 ﻿// fms_variate_constant.h - constant variate
 #pragma once
 #include <cmath>
+#include <complex>
 #include <limits>
+#include <span>
+#include "fms_ensure.h"
 
 namespace fms::variate {
 
@@ -10,8 +13,8 @@ namespace fms::variate {
 	class constant {
 		X c;
 	public:
-		typedef typename X xtype;
-		typedef typename S stype;
+		typedef X xtype;
+		typedef S stype;
 
 		constant(X c)
 			: c(c)
@@ -44,6 +47,27 @@ namespace fms::variate {
 
 			return 0;
 		}
+		// kappa(z) = cz
+		std::complex<S> cumulant(std::complex<S> z) const
+		{
+			return c * z;
+		}
+
+		// smallest x with 1(c <= x) >= p
+		X quantile(X p, S = 0) const
+		{
+			ensure(0 <= p and p <= 1);
+
+			return p == 0 ? -std::numeric_limits<X>::infinity() : c;
+		}
+
+		template<class G>
+		void sample(G&, std::span<X> out, S = 0) const
+		{
+			for (auto& x : out) {
+				x = c;
+			}
+		}
 
 		// F_s(x) = 1(c <= x) does not depend on s
 		X edf(S, X) const
@@ -1,5 +1,8 @@
 // fms_variate_constant.t.cpp - test constant variate
 #include <cassert>
+#include <random>
+#include "fms_variate.h"
+#include "fms_variate_sample.h"
 #include "fms_variate_constant.h"
 
 using namespace fms::variate;
@@ -27,8 +30,26 @@ int test_variate_constant()
 			assert(c.edf(s, 1.22) == 0);
 			assert(c.edf(s, 1.23) == 0);
 			assert(c.edf(s, 1.24) == 0);
+
+			double jet[3];
+			cdf_jet(c, 1.24, s, 2, std::span<double>(jet));
+			assert(jet[0] == 1 and jet[1] == 0 and std::isnan(jet[2]));
+
+			assert(quantile(c, 0.5, s) == 1.23);
+			assert(quantile(c, 1., s) == 1.23);
+			assert(quantile(c, 0., s) == -std::numeric_limits<double>::infinity());
 		}
 	}
+	{
+		constant c(1.23);
+		affine<constant<double>> v(c, 1, 2);
+		assert(quantile(v, 0.3) == 1 + 2 * 1.23);
+
+		std::mt19937 r;
+		double x[3];
+		sample(v, r, std::span<double>(x));
+		assert(x[0] == 1 + 2 * 1.23 and x[2] == x[0]);
+	}
 
 	return 0;
 }
@@ -0,0 +1,394 @@
+// fms_variate_discrete.h - discrete variate with finitely many atoms
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_random.h"
+#include "fms_sf_simd.h"
+#include "fms_simd.h"
+#include "fms_variate.h"
+#include "fms_variate_cache.h"
+
+namespace fms::variate {
+
+	static inline const char discrete_doc[] = R"xyzyx(
+The discrete variate \(X\) takes the value \(x_i\) with probability \(p_i\).
+Its cumulant is \(\kappa(s) = \log\sum_i p_i e^{sx_i}\) and the Esscher transform has
+probabilities \(p_i e^{sx_i - \kappa(s)}\). The derivatives of the cumulant are the cumulants of the transformed variate.
+Atoms are sorted and stored in breadth first (Eytzinger) order so the cdf is a branch free search
+that touches one cache line per level. The cumulative probabilities are computed once for each \(s\)
+and the last few are cached. Walker's alias table for sampling in constant time is only built when sampling.
+)xyzyx";
+	template<class X = double, class S = X>
+	class discrete {
+		std::vector<X> x; // sorted distinct atoms
+		std::vector<X> p; // their probabilities
+		std::vector<X> e; // e[k] = x[r[k]] in Eytzinger order for 1 <= k <= n
+		std::vector<uint32_t> r; // r[0] = n
+
+		// Esscher transformed probabilities
+		struct esscher {
+			S s;
+			S mean;
+			// in Eytzinger order with index 0 for the point at infinity
+			std::vector<X> P; // P[k] = P_s(X < e[k]), P[0] = 1
+			std::vector<X> D; // D[k] = E_s[1(X < e[k])(X - mean)], D[0] = 0
+		};
+		// Walker's alias table for sampling from X_s
+		struct walker {
+			S s;
+			std::vector<X> prob;
+			std::vector<uint32_t> alias;
+		};
+		mutable s_cache<esscher> cache;
+		mutable s_cache<walker, 2> walkers;
+
+		// fill e and r by an in order traversal of the implicit tree
+		size_t eytzinger(size_t i, size_t k)
+		{
+			if (k < e.size()) {
+				i = eytzinger(i, 2 * k);
+				e[k] = x[i];
+				r[k] = static_cast<uint32_t>(i);
+				i = eytzinger(i + 1, 2 * k + 1);
+			}
+
+			return i;
+		}
+
+		void init(std::span<const X> x_, std::span<const X> p_)
+		{
+			ensure(x_.size() == p_.size());
+			ensure(x_.size() > 0 and x_.size() < std::numeric_limits<uint32_t>::max());
+
+			std::vector<size_t> k(x_.size());
+			std::iota(k.begin(), k.end(), size_t(0));
+			std::sort(k.begin(), k.end(), [x_](size_t i, size_t j) { return x_[i] < x_[j]; });
+
+			X total = 0;
+			for (size_t i : k) {
+				ensure(std::isfinite(x_[i]));
+				ensure(p_[i] >= 0);
+				if (p_[i] == 0) {
+					continue;
+				}
+				if (!x.empty() and x.back() == x_[i]) {
+					p.back() += p_[i];
+				}
+				else {
+					x.push_back(x_[i]);
+					p.push_back(p_[i]);
+				}
+				total += p_[i];
+			}
+			ensure(total > 0 and std::isfinite(total));
+			for (auto& pi : p) {
+				pi /= total;
+			}
+
+			e.resize(x.size() + 1);
+			r.resize(x.size() + 1);
+			e[0] = std::numeric_limits<X>::quiet_NaN();
+			r[0] = static_cast<uint32_t>(x.size());
+			eytzinger(0, 1);
+		}
+
+		// w[i] = p[i] exp(s x[i] - m) where m is the largest s x[i]
+		S weights(S s, std::vector<S>& w) const
+		{
+			size_t n = x.size();
+			S m = s * (s < 0 ? x.front() : x.back());
+			w.resize(n);
+			for (size_t i = 0; i < n; ++i) {
+				w[i] = s * x[i] - m;
+			}
+			if constexpr (std::is_same_v<S, double>) {
+				sf::exp(std::span<const S>(w), std::span<S>(w));
+			}
+			else {
+				for (auto& wi : w) {
+					wi = exp(wi);
+				}
+			}
+			for (size_t i = 0; i < n; ++i) {
+				w[i] *= p[i];
+			}
+
+			return m;
+		}
+		// q[i] = P_s(X = x[i])
+		void transformed(S s, std::vector<S>& q) const
+		{
+			weights(s, q);
+			S W = std::accumulate(q.begin(), q.end(), S(0));
+			for (auto& qi : q) {
+				qi /= W;
+			}
+		}
+
+		std::shared_ptr<const esscher> build(S s) const
+		{
+			size_t n = x.size();
+			auto c = std::make_shared<esscher>();
+			c->s = s;
+
+			std::vector<S> q;
+			transformed(s, q);
+			c->mean = 0;
+			for (size_t i = 0; i < n; ++i) {
+				c->mean += q[i] * x[i];
+			}
+
+			// cumulative sums in sorted order
+			std::vector<X> P(n + 1), D(n + 1);
+			P[0] = D[0] = 0;
+			for (size_t i = 0; i < n; ++i) {
+				P[i + 1] = P[i] + X(q[i]);
+				D[i + 1] = D[i] + X(q[i] * (x[i] - c->mean));
+			}
+			c->P.resize(n + 1);
+			c->D.resize(n + 1);
+			c->P[0] = 1;
+			c->D[0] = 0;
+			for (size_t k = 1; k <= n; ++k) {
+				c->P[k] = P[r[k]] / P[n];
+				c->D[k] = D[r[k]];
+			}
+
+			return c;
+		}
+
+		std::shared_ptr<const walker> build_walker(S s) const
+		{
+			size_t n = x.size();
+			auto c = std::make_shared<walker>();
+			c->s = s;
+
+			std::vector<S> q;
+			transformed(s, q);
+
+			// Vose's method
+			c->prob.resize(n);
+			c->alias.resize(n);
+			std::vector<uint32_t> small, large;
+			for (size_t i = 0; i < n; ++i) {
+				c->prob[i] = X(q[i] * S(n));
+				(c->prob[i] < 1 ? small : large).push_back(static_cast<uint32_t>(i));
+			}
+			while (!small.empty() and !large.empty()) {
+				uint32_t l = small.back(), g = large.back();
+				small.pop_back();
+				c->alias[l] = g;
+				c->prob[g] -= 1 - c->prob[l];
+				if (c->prob[g] < 1) {
+					large.pop_back();
+					small.push_back(g);
+				}
+			}
+			// rounding leaves these within epsilon of 1
+			for (uint32_t i : small) {
+				c->prob[i] = 1;
+				c->alias[i] = i;
+			}
+			for (uint32_t i : large) {
+				c->prob[i] = 1;
+				c->alias[i] = i;
+			}
+
+			return c;
+		}
+
+		// cached transform for s
+		std::shared_ptr<const esscher> at(S s) const
+		{
+			return cache.at(s, [this](S t) { return build(t); });
+		}
+
+		// Smallest k in Eytzinger order with less(a[k]) false, or 0 if none.
+		// The descent has no data dependent branches and prefetches the line holding the
+		// great-grandchildren of each node so the memory latency of three levels overlaps.
+		template<class L>
+		static size_t search(const std::vector<X>& a, const L& less)
+		{
+			size_t k = 1, n = a.size();
+			while (k < n) {
+				simd::prefetch(a.data() + std::min(8 * k, n - 1));
+				k = 2 * k + less(a[k]);
+			}
+
+			return k >> (std::countr_one(k) + 1);
+		}
+		// first atom greater than x_ in Eytzinger order, or 0 if none
+		size_t upper(X x_) const
+		{
+			return search(e, [x_](X ek) { return ek <= x_; });
+		}
+
+		// F_s^{(n)}(x_) given the first atom greater than x_
+		X value(const esscher& c, X x_, size_t k, unsigned n) const
+		{
+			if (n == 0) {
+				return c.P[k];
+			}
+			size_t i = r[k]; // number of atoms not greater than x_
+			if (i == 0 or x[i - 1] != x_) {
+				return 0;
+			}
+
+			// really a multiple of delta^{(n - 1)}
+			return n == 1 ? std::numeric_limits<X>::infinity() : std::numeric_limits<X>::quiet_NaN();
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// constant 0
+		discrete()
+		{
+			X x0 = 0, p0 = 1;
+			init(std::span<const X>(&x0, 1), std::span<const X>(&p0, 1));
+		}
+		// P(X = x[i]) proportional to p[i]
+		discrete(std::span<const X> x, std::span<const X> p)
+		{
+			init(x, p);
+		}
+		discrete(size_t n, const X* x, const X* p)
+			: discrete(std::span<const X>(x, n), std::span<const X>(p, n))
+		{ }
+
+		// sorted distinct atoms with positive probability
+		std::span<const X> atoms() const
+		{
+			return x;
+		}
+		std::span<const X> probabilities() const
+		{
+			return p;
+		}
+
+		// F_s(x) = P_s(X <= x)
+		X cdf(X x_, S s = 0, unsigned n = 0) const
+		{
+			auto c = at(s);
+
+			return value(*c, x_, upper(x_), n);
+		}
+		// out[i] = cdf(x[i], s, n) using one transform, x and out may alias
+		void cdf(std::span<const X> x_, S s, unsigned n, std::span<X> out) const
+		{
+			ensure(out.size() >= x_.size());
+			auto c = at(s);
+
+			for (size_t i = 0; i < x_.size(); ++i) {
+				out[i] = value(*c, x_[i], upper(x_[i]), n);
+			}
+		}
+
+		// kappa(s), ..., kappa^{(N)}(s) from the central moments of X_s
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			ensure(out.size() > N);
+
+			std::vector<S> w;
+			S m = weights(s, w);
+			S W = std::accumulate(w.begin(), w.end(), S(0));
+			out[0] = m + log(W);
+			if (N == 0) {
+				return;
+			}
+
+			S mean = 0;
+			for (size_t i = 0; i < x.size(); ++i) {
+				w[i] /= W;
+				mean += w[i] * x[i];
+			}
+			out[1] = mean;
+
+			// mu[k] = E_s[(X - mean)^k]
+			std::vector<S> mu(N + 1, S(0)), d(x.size());
+			mu[0] = 1;
+			for (size_t i = 0; i < x.size(); ++i) {
+				d[i] = w[i];
+			}
+			for (unsigned k = 2; k <= N; ++k) {
+				S muk = 0;
+				for (size_t i = 0; i < x.size(); ++i) {
+					d[i] *= x[i] - mean;
+					muk += d[i] * (x[i] - mean);
+				}
+				mu[k] = muk;
+			}
+			cumulant_from_central<S>(mu, N, out);
+		}
+		S cumulant(S s, unsigned n = 0) const
+		{
+			S k[8];
+			std::vector<S> k_;
+			std::span<S> out(k);
+			if (n >= 8) {
+				k_.resize(n + 1);
+				out = k_;
+			}
+			cumulant_jet(s, n, out);
+
+			return out[n];
+		}
+		// log sum_i p_i exp(z x_i) scaled by the largest real part
+		std::complex<S> cumulant(std::complex<S> z) const
+		{
+			S m = z.real() * (z.real() < 0 ? x.front() : x.back());
+			std::complex<S> W = 0;
+			for (size_t i = 0; i < x.size(); ++i) {
+				W += p[i] * exp(z * x[i] - m);
+			}
+
+			return m + log(W);
+		}
+
+		// smallest atom with F_s(x) >= u
+		X quantile(X u, S s = 0) const
+		{
+			ensure(0 <= u and u <= 1);
+			if (u == 0) {
+				return -std::numeric_limits<X>::infinity();
+			}
+			auto c = at(s);
+			// first atom with P_s(X < x_i) >= u follows the answer
+			size_t k = search(c->P, [u](X Pk) { return Pk < u; });
+
+			return k == 0 ? x.back() : x[r[k] - 1];
+		}
+
+		// Walker's alias method using one 64 bit draw per sample
+		template<std::uniform_random_bit_generator G>
+		void sample(G& g, std::span<X> out, S s = 0) const
+		{
+			auto c = walkers.at(s, [this](S t) { return build_walker(t); });
+			size_t n = x.size();
+			for (auto& xi : out) {
+				X u = X(random::uniform(g)) * X(n);
+				size_t i = std::min(static_cast<size_t>(u), n - 1);
+				xi = x[u - X(i) < c->prob[i] ? i : c->alias[i]];
+			}
+		}
+
+		// d/ds F_s(x) = E_s[1(X <= x)(X - kappa'(s))]
+		X edf(S s, X x_) const
+		{
+			auto c = at(s);
+
+			return c->D[upper(x_)];
+		}
+	};
+
+}
@@ -0,0 +1,185 @@
+// fms_variate_discrete.t.cpp - test discrete variate
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+#include "fms_variate.h"
+#include "fms_variate_discrete.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<discrete<>>);
+static_assert(variate_batch_concept<discrete<>>);
+static_assert(std::is_nothrow_move_constructible_v<discrete<>>);
+static_assert(variate_quantile_concept<discrete<>>);
+static_assert(variate_cumulant_jet_concept<discrete<>>);
+static_assert(variate_cumulant_complex_concept<discrete<>>);
+
+template<class X>
+int test_variate_discrete()
+{
+	{
+		// Bernoulli with P(X = 1) = 0.3 given in any order with a repeated and a null atom
+		X x[] = { 1, 0, X(0.5), 1 };
+		X p[] = { X(0.1), X(0.7), 0, X(0.2) };
+		discrete<X> B(4, x, p);
+		assert(B.atoms().size() == 2);
+		assert(B.cdf(-1) == 0);
+		assert(fabs(B.cdf(0) - X(0.7)) < 1e-15);
+		assert(fabs(B.cdf(X(0.5)) - X(0.7)) < 1e-15);
+		assert(B.cdf(1) == 1);
+		assert(B.cdf(X(0.5), 0, 1) == 0);
+		assert(B.cdf(1, 0, 1) == std::numeric_limits<X>::infinity());
+		assert(B.quantile(X(0.7)) == 0);
+		assert(B.quantile(X(0.71)) == 1);
+
+		for (X s : { X(-1), X(0), X(0.5) }) {
+			// P_s(X = 1) = q
+			X q = X(0.3) * exp(s) / (X(0.7) + X(0.3) * exp(s));
+			X k[5];
+			B.cumulant_jet(s, 4, std::span<X>(k));
+			assert(fabs(k[0] - log(X(0.7) + X(0.3) * exp(s))) < 1e-15);
+			assert(fabs(k[1] - q) < 1e-15);
+			assert(fabs(k[2] - q * (1 - q)) < 1e-15);
+			assert(fabs(k[3] - q * (1 - q) * (1 - 2 * q)) < 1e-15);
+			assert(fabs(k[4] - q * (1 - q) * (1 - 6 * q * (1 - q))) < 1e-15);
+			assert(B.cumulant(s, 3) == k[3]);
+			assert(fabs(B.cdf(0, s) - (1 - q)) < 1e-15);
+			// d/ds (1 - q) = -q(1 - q)
+			assert(fabs(B.edf(s, 0) + q * (1 - q)) < 1e-15);
+			assert(fabs(B.cumulant(std::complex<X>(s, 0)).real() - k[0]) < 1e-15);
+		}
+	}
+	{
+		// many atoms agree with brute force
+		random::philox g(11);
+		size_t n = 1000;
+		std::vector<X> x(n), p(n);
+		for (size_t i = 0; i < n; ++i) {
+			x[i] = X(random::normal(g));
+			p[i] = X(random::uniform(g));
+		}
+		discrete<X> D(x, p);
+		X total = 0;
+		for (X pi : p) {
+			total += pi;
+		}
+		X s = X(0.7);
+		X kappa = 0;
+		for (size_t i = 0; i < n; ++i) {
+			kappa += p[i] / total * exp(s * x[i]);
+		}
+		kappa = log(kappa);
+		assert(fabs(D.cumulant(s) - kappa) < 1e-14);
+		std::vector<X> y = { X(-5), X(-1), x[17], X(0), X(0.3), x[500], X(5) }, F(y.size());
+		D.cdf(y, s, 0, F);
+		for (size_t j = 0; j < y.size(); ++j) {
+			X F_ = 0;
+			for (size_t i = 0; i < n; ++i) {
+				F_ += (x[i] <= y[j]) * p[i] / total * exp(s * x[i] - kappa);
+			}
+			assert(fabs(F[j] - F_) < 1e-14);
+			assert(D.cdf(y[j], s) == F[j]);
+
+			X ds = X(1e-5);
+			assert(fabs(D.edf(s, y[j]) - (D.cdf(y[j], s + ds) - D.cdf(y[j], s - ds)) / (2 * ds)) < 1e-9);
+		}
+		// higher cumulants are derivatives of the lower ones
+		X k[7], k_[7], k__[7], ds = X(1e-4);
+		D.cumulant_jet(s, 6, std::span<X>(k));
+		D.cumulant_jet(s + ds, 6, std::span<X>(k_));
+		D.cumulant_jet(s - ds, 6, std::span<X>(k__));
+		for (unsigned j = 0; j < 6; ++j) {
+			assert(fabs(k[j + 1] - (k_[j] - k__[j]) / (2 * ds)) < 1e-6 * std::max(X(1), fabs(k[j + 1])));
+		}
+
+		// alias sampling
+		std::vector<X> z(200'000);
+		D.sample(g, std::span<X>(z), s);
+		X mean = 0;
+		for (X zi : z) {
+			mean += zi / X(z.size());
+		}
+		assert(fabs(mean - k[1]) < 5 * sqrt(k[2] / X(z.size())));
+		X F0 = D.cdf(0, s);
+		X P0 = X(std::count_if(z.begin(), z.end(), [](X zi) { return zi <= 0; })) / X(z.size());
+		assert(fabs(P0 - F0) < 5 * sqrt(F0 * (1 - F0) / X(z.size())));
+
+		// copies share the transform
+		auto D_ = D;
+		assert(D_.cdf(X(0.3), s) == D.cdf(X(0.3), s));
+		// moves do not copy the atoms
+		const X* a = D_.atoms().data();
+		auto D__ = std::move(D_);
+		assert(D__.atoms().data() == a);
+		assert(D__.cdf(X(0.3), s) == D.cdf(X(0.3), s));
+		for (X u : { X(0.01), X(0.5), X(0.99) }) {
+			X q = D.quantile(u, s);
+			assert(D.cdf(q, s) >= u);
+			assert(D.cdf(std::nextafter(q, X(-10)), s) < u);
+		}
+	}
+
+	return 0;
+}
+int test_variate_discrete_d = test_variate_discrete<double>();
+
+// Eytzinger search versus binary search over sorted atoms
+int benchmark_variate_discrete()
+{
+	random::philox g(3);
+	size_t n = 1 << 22, m = 1 << 20;
+	std::vector<double> x(n), p(n, 1.), y(m), F(m);
+	for (size_t i = 0; i < n; ++i) {
+		x[i] = random::normal(g);
+	}
+	for (auto& yi : y) {
+		yi = 4 * random::normal(g);
+	}
+	discrete<> D(x, p);
+	D.cdf(0.);
+	std::span<const double> a = D.atoms();
+	std::vector<double> P(a.size() + 1, 0.);
+	for (size_t i = 0; i < a.size(); ++i) {
+		P[i + 1] = P[i] + D.probabilities()[i];
+	}
+
+	double ms = test::time([&]() { D.cdf(y, 0, 0, F); });
+	double ms_std = test::time([&]() {
+		for (size_t i = 0; i < m; ++i) {
+			F[i] = P[std::upper_bound(a.begin(), a.end(), y[i]) - a.begin()];
+		}
+	});
+	assert(ms < 4 * ms_std); // not horrible
+
+	return ms < ms_std;
+}
+int benchmark_variate_discrete_ = benchmark_variate_discrete();
+
+// central differences in s reuse the cached transforms
+int benchmark_variate_discrete_s()
+{
+	random::philox g(5);
+	size_t n = 1 << 22;
+	std::vector<double> x(n), p(n, 1.);
+	for (size_t i = 0; i < n; ++i) {
+		x[i] = random::normal(g);
+	}
+	discrete<> D(x, p);
+	double s = 0.1, ds = 1e-4, sum = 0;
+
+	double ms_build = test::time([&]() { sum += D.cdf(0.5, s); });
+	double ms = test::time([&]() {
+		for (int k = 0; k < 20; ++k) {
+			sum += D.cdf(0.5, s + ds) - D.cdf(0.5, s - ds) + D.cdf(0.5, s);
+		}
+	});
+	assert(ms < 4 * ms_build); // two more builds
+
+	return sum != 0;
+}
+int benchmark_variate_discrete_s_ = benchmark_variate_discrete_s();
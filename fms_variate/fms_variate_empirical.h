@@ -0,0 +1,377 @@
+// fms_variate_empirical.h - empirical distribution of a memory mapped file of samples
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_mmap.h"
+#include "fms_parallel.h"
+#include "fms_sf_simd.h"
+#include "fms_variate.h"
+#include "fms_variate_cache.h"
+
+namespace fms::variate {
+
+	static inline const char empirical_doc[] = R"xyzyx(
+The empirical variate puts mass \(1/n\) on each of the samples \(x_1, \ldots, x_n\) in a flat binary file.
+The first time a file is opened its samples are sorted into a sidecar file with the suffix <code>.sorted</code>
+that records the size and modification time of the original. Later opens map the sidecar directly and
+the samples are never copied to the heap.
+The cdf is a binary search. For \(s \ne 0\) the Esscher transformed weights \(e^{sx_i - \kappa(s)}/n\)
+are summed over blocks of 1024 samples in parallel once and cached so the cdf sums at most one block.
+Cumulants are the cumulants of the transformed variate using weights shifted by the largest \(sx_i\) and
+central moments about the transformed mean, reduced over chunks in a fixed order so results do not
+depend on the number of threads.
+)xyzyx";
+	template<class X = double, class S = X>
+	class empirical {
+		static constexpr size_t block = 1 << 10; // samples per cached partial sum
+		static constexpr size_t chunk = 1 << 16; // samples per parallel task
+
+		// sidecar file layout followed by count sorted samples
+		struct header {
+			char magic[8];
+			uint64_t count;
+			uint64_t size; // bytes in the original file
+			int64_t time; // last write time of the original file
+			uint64_t bytes; // sizeof(X)
+			uint64_t reserved[3];
+		};
+		static_assert(sizeof(header) == 64);
+		static constexpr char magic[8] = "FMS.EMP";
+
+		std::shared_ptr<const mmap::view> m;
+		std::span<const X> x; // sorted samples
+		unsigned n_threads;
+
+		// partial sums of the Esscher transformed weights w_i = exp(s x_i - max) / W
+		struct esscher {
+			S s;
+			S max, W; // largest s x_i and sum of exp(s x_i - max)
+			S mean;
+			std::vector<S> B; // B[j] = sum of w_i for i < j block
+			std::vector<S> D; // D[j] = sum of w_i (x_i - mean) for i < j block
+		};
+		mutable s_cache<esscher> cache;
+
+		static header stamp(const std::filesystem::path& path, size_t count)
+		{
+			header h{};
+			std::memcpy(h.magic, magic, sizeof(magic));
+			h.count = count;
+			h.size = std::filesystem::file_size(path);
+			h.time = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+			h.bytes = sizeof(X);
+
+			return h;
+		}
+
+		// w[i] = exp(s y[i] - max)
+		static void weights(S s, S max, std::span<const X> y, std::span<S> w)
+		{
+			for (size_t i = 0; i < y.size(); ++i) {
+				w[i] = s * y[i] - max;
+			}
+			if constexpr (std::is_same_v<S, double>) {
+				sf::exp(std::span<const S>(w.data(), y.size()), w);
+			}
+			else {
+				for (size_t i = 0; i < y.size(); ++i) {
+					w[i] = exp(w[i]);
+				}
+			}
+		}
+		S max(S s) const
+		{
+			return s * (s < 0 ? x.front() : x.back());
+		}
+
+		// out[j (N + 1) + k] = sum of w_i (x_i - c)^k over samples j b <= i < (j + 1) b
+		void sums(S s, S c, unsigned N, size_t b, std::vector<S>& out) const
+		{
+			size_t nb = (x.size() + b - 1) / b;
+			S max_ = max(s);
+			out.assign(nb * (N + 1), S(0));
+			parallel::for_each(nb, [&](size_t j) {
+				S w[block];
+				S* o = out.data() + j * (N + 1);
+				size_t end = std::min(x.size(), (j + 1) * b);
+				for (size_t i0 = j * b; i0 < end; i0 += block) {
+					size_t len = std::min(block, end - i0);
+					weights(s, max_, x.subspan(i0, len), std::span<S>(w, len));
+					for (size_t i = 0; i < len; ++i) {
+						S d = x[i0 + i] - c, wd = w[i];
+						for (unsigned k = 0; k <= N; ++k) {
+							o[k] += wd;
+							wd *= d;
+						}
+					}
+				}
+			}, n_threads);
+		}
+
+		std::shared_ptr<const esscher> build(S s) const
+		{
+			size_t nb = (x.size() + block - 1) / block;
+			auto e = std::make_shared<esscher>();
+			e->s = s;
+			e->max = max(s);
+
+			std::vector<S> o;
+			sums(s, 0, 1, block, o);
+			e->W = 0;
+			S Wx = 0;
+			for (size_t j = 0; j < nb; ++j) {
+				e->W += o[2 * j];
+				Wx += o[2 * j + 1];
+			}
+			e->mean = Wx / e->W;
+
+			e->B.resize(nb + 1);
+			e->D.resize(nb + 1);
+			e->B[0] = e->D[0] = 0;
+			for (size_t j = 0; j < nb; ++j) {
+				e->B[j + 1] = e->B[j] + o[2 * j] / e->W;
+			}
+			sums(s, e->mean, 1, block, o);
+			for (size_t j = 0; j < nb; ++j) {
+				e->D[j + 1] = e->D[j] + o[2 * j + 1] / e->W;
+			}
+
+			return e;
+		}
+
+		// cached transform for s
+		std::shared_ptr<const esscher> at(S s) const
+		{
+			return cache.at(s, [this](S t) { return build(t); });
+		}
+
+		// number of samples not greater than x_
+		size_t count(X x_) const
+		{
+			return std::upper_bound(x.begin(), x.end(), x_) - x.begin();
+		}
+		// P_s(X < x[k]) and E_s[1(X < x[k])(X - mean)]
+		std::pair<S, S> prefix(const esscher& e, size_t k) const
+		{
+			size_t j = k / block;
+			S P = 0, D = 0;
+			for (size_t i = j * block; i < k; ++i) {
+				S w = exp(e.s * x[i] - e.max);
+				P += w;
+				D += w * (x[i] - e.mean);
+			}
+
+			return { e.B[j] + P / e.W, e.D[j] + D / e.W };
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// no samples
+		empirical()
+			: n_threads(0)
+		{ }
+		// Samples of type X in the file path. Sort them into the sidecar file if it is missing or out of date.
+		empirical(const std::filesystem::path& path, unsigned threads = 0)
+			: n_threads(threads)
+		{
+			if (!indexed(path)) {
+				index(path);
+			}
+			m = std::make_shared<const mmap::view>(sidecar(path));
+			const header* h = reinterpret_cast<const header*>(m->data());
+			x = std::span<const X>(reinterpret_cast<const X*>(m->data() + sizeof(header)), h->count);
+		}
+
+		static std::filesystem::path sidecar(const std::filesystem::path& path)
+		{
+			auto p = path;
+
+			return p += ".sorted";
+		}
+		// sidecar exists and matches the size and time of path
+		static bool indexed(const std::filesystem::path& path)
+		{
+			std::error_code ec;
+			auto p = sidecar(path);
+			if (!std::filesystem::exists(p, ec) or std::filesystem::file_size(p, ec) < sizeof(header)) {
+				return false;
+			}
+
+			mmap::view v(p);
+			header h;
+			std::memcpy(&h, v.data(), sizeof(header));
+			header h_ = stamp(path, h.count);
+
+			return std::memcmp(&h, &h_, sizeof(header)) == 0 and v.size() == sizeof(header) + h.count * sizeof(X)
+				and h.size == h.count * sizeof(X);
+		}
+		// Sort the samples in path into a temporary file and rename it to the sidecar.
+		// The temporary name is unique to the call so concurrent indexers never share it.
+		static void index(const std::filesystem::path& path)
+		{
+			static std::atomic<uint64_t> calls = 0;
+
+			mmap::view src(path);
+			ensure(src.size() > 0 and src.size() % sizeof(X) == 0);
+			size_t n = src.size() / sizeof(X);
+
+			uint64_t id = (uint64_t(std::random_device{}()) << 32) ^ std::hash<std::thread::id>{}(std::this_thread::get_id())
+				^ calls.fetch_add(1);
+			auto tmp = sidecar(path);
+			tmp += "." + std::to_string(id) + ".tmp";
+			try {
+				mmap::view dst(tmp, sizeof(header) + n * sizeof(X));
+				X* y = reinterpret_cast<X*>(dst.data() + sizeof(header));
+				std::memcpy(y, src.data(), n * sizeof(X));
+				ensure(std::all_of(y, y + n, [](X yi) { return std::isfinite(yi); }));
+				std::sort(y, y + n);
+				header h = stamp(path, n);
+				std::memcpy(dst.data(), &h, sizeof(header));
+				dst.flush();
+			}
+			catch (...) {
+				std::error_code ec;
+				std::filesystem::remove(tmp, ec);
+				throw;
+			}
+			std::error_code ec;
+			std::filesystem::rename(tmp, sidecar(path), ec);
+			if (ec) {
+				// Windows will not replace a sidecar another indexer has mapped
+				std::filesystem::remove(tmp, ec);
+				ensure(indexed(path));
+			}
+		}
+
+		// sorted samples
+		std::span<const X> samples() const
+		{
+			return x;
+		}
+
+		X cdf(X x_, S s = 0, unsigned n = 0) const
+		{
+			ensure(!x.empty());
+			size_t k = count(x_);
+
+			if (n > 0) {
+				if (k == 0 or x[k - 1] != x_) {
+					return 0;
+				}
+
+				// really a multiple of delta^{(n - 1)}
+				return n == 1 ? std::numeric_limits<X>::infinity() : std::numeric_limits<X>::quiet_NaN();
+			}
+			if (s == 0) {
+				return X(k) / X(x.size());
+			}
+
+			return X(prefix(*at(s), k).first);
+		}
+
+		// kappa(s), ..., kappa^{(N)}(s) from the central moments of X_s
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			ensure(!x.empty());
+			ensure(out.size() > N);
+
+			std::vector<S> o;
+			sums(s, 0, 1, chunk, o);
+			S W = 0, Wx = 0;
+			for (size_t j = 0; j < o.size(); j += 2) {
+				W += o[j];
+				Wx += o[j + 1];
+			}
+			out[0] = max(s) + log(W / S(x.size()));
+			if (N == 0) {
+				return;
+			}
+			S mean = Wx / W;
+			out[1] = mean;
+			if (N == 1) {
+				return;
+			}
+
+			sums(s, mean, N, chunk, o);
+			std::vector<S> mu(N + 1, S(0));
+			for (size_t j = 0; j < o.size(); j += N + 1) {
+				for (unsigned k = 0; k <= N; ++k) {
+					mu[k] += o[j + k];
+				}
+			}
+			for (unsigned k = 0; k <= N; ++k) {
+				mu[k] /= W;
+			}
+			cumulant_from_central<S>(mu, N, out);
+		}
+		S cumulant(S s, unsigned n = 0) const
+		{
+			std::vector<S> k(n + 1);
+			cumulant_jet(s, n, k);
+
+			return k[n];
+		}
+
+		// smallest sample with F_s(x) >= u
+		X quantile(X u, S s = 0) const
+		{
+			ensure(!x.empty());
+			ensure(0 <= u and u <= 1);
+
+			if (u == 0) {
+				return -std::numeric_limits<X>::infinity();
+			}
+			if (s == 0) {
+				// smallest k with k/n >= u computed as in cdf, u n may round past k
+				size_t n = x.size();
+				size_t k = std::clamp(static_cast<size_t>(std::ceil(u * X(n))), size_t(1), n);
+				while (k > 1 and X(k - 1) / X(n) >= u) {
+					--k;
+				}
+				while (k < n and X(k) / X(n) < u) {
+					++k;
+				}
+
+				return x[k - 1];
+			}
+
+			auto e = at(s);
+			// last block starting below u then the first k with prefix(k) >= u summed as in cdf
+			size_t j = std::lower_bound(e->B.begin() + 1, e->B.end(), S(u)) - e->B.begin() - 1;
+			S P = 0;
+			size_t end = std::min(x.size(), (j + 1) * block);
+			for (size_t k = j * block + 1; k <= end; ++k) {
+				P += exp(s * x[k - 1] - e->max);
+				S F = k % block ? e->B[j] + P / e->W : e->B[k / block];
+				if (X(F) >= u) {
+					return x[k - 1];
+				}
+			}
+
+			return x[end - 1];
+		}
+
+		// d/ds F_s(x) = E_s[1(X <= x)(X - kappa'(s))]
+		X edf(S s, X x_) const
+		{
+			ensure(!x.empty());
+
+			return X(prefix(*at(s), count(x_)).second);
+		}
+	};
+
+}
@@ -0,0 +1,141 @@
+// fms_variate_empirical.t.cpp - test empirical variate
+#include <cassert>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+#include "fms_variate.h"
+#include "fms_variate_discrete.h"
+#include "fms_variate_empirical.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<empirical<>>);
+static_assert(variate_quantile_concept<empirical<>>);
+static_assert(variate_cumulant_jet_concept<empirical<>>);
+
+// write n samples from a normal mixture to a temporary file
+inline std::filesystem::path test_variate_empirical_file(const char* name, size_t n, std::vector<double>& x)
+{
+	random::philox g(n);
+	x.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		x[i] = random::normal(g) * (i % 3 ? 1 : 3) + (i % 5 ? 0 : 1);
+	}
+	auto path = std::filesystem::temp_directory_path() / name;
+	std::filesystem::remove(empirical<>::sidecar(path));
+	std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(x.data()), n * sizeof(double));
+
+	return path;
+}
+
+int test_variate_empirical()
+{
+	std::vector<double> x;
+	auto path = test_variate_empirical_file("fms_variate_empirical.bin", 100'000, x);
+	assert(!empirical<>::indexed(path));
+	{
+		empirical<> E(path);
+		assert(empirical<>::indexed(path));
+		assert(std::is_sorted(E.samples().begin(), E.samples().end()));
+
+		// same as the discrete variate with equal probabilities
+		std::vector<double> p(x.size(), 1);
+		discrete<> D(x, p);
+		for (double s : { -0.5, 0., 0.3 }) {
+			for (double y : { -10., -2., x[7], 0., 0.5, x[99], 3. }) {
+				assert(fabs(E.cdf(y, s) - D.cdf(y, s)) < 1e-11);
+				assert(fabs(E.edf(s, y) - D.edf(s, y)) < 1e-11);
+				assert(E.cdf(y, s, 1) == D.cdf(y, s, 1));
+			}
+			double k[5], k_[5];
+			E.cumulant_jet(s, 4, std::span<double>(k));
+			D.cumulant_jet(s, 4, std::span<double>(k_));
+			for (unsigned n = 0; n <= 4; ++n) {
+				assert(fabs(k[n] - k_[n]) < 1e-11 * std::max(1., fabs(k_[n])));
+			}
+			for (double u : { 1e-4, 0.1, 0.5, 0.77, 0.99999 }) {
+				double q = E.quantile(u, s);
+				assert(E.cdf(q, s) >= u);
+				assert(E.cdf(std::nextafter(q, -100.), s) < u);
+			}
+		}
+
+		// results do not depend on the number of threads
+		empirical<> E1(path, 1);
+		assert(E1.cumulant(0.3, 3) == E.cumulant(0.3, 3));
+		assert(E1.cdf(0.5, 0.3) == E.cdf(0.5, 0.3));
+	}
+	{
+		// rewriting the file rebuilds the sidecar
+		auto t = std::filesystem::last_write_time(path);
+		x.resize(10);
+		std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(x.data()), x.size() * sizeof(double));
+		std::filesystem::last_write_time(path, t + std::chrono::seconds(1));
+		assert(!empirical<>::indexed(path));
+		empirical<> E(path);
+		assert(E.samples().size() == 10);
+	}
+	{
+		// quantile inverts cdf at every sample when u n is not exact
+		for (size_t n : { 25, 999 }) {
+			std::vector<double> y;
+			auto path_ = test_variate_empirical_file("fms_variate_empirical_quantile.bin", n, y);
+			{
+				empirical<> E(path_);
+				for (double s : { 0., 0.3 }) {
+					for (double yk : E.samples()) {
+						assert(E.quantile(E.cdf(yk, s), s) == yk);
+					}
+				}
+			}
+			std::filesystem::remove(empirical<>::sidecar(path_));
+			std::filesystem::remove(path_);
+		}
+	}
+	{
+		// concurrent indexers write their own temporary files
+		x.resize(1000);
+		std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(x.data()), x.size() * sizeof(double));
+		std::filesystem::remove(empirical<>::sidecar(path));
+		parallel::for_each(8, [&path, &x](size_t) {
+			empirical<> E(path);
+			ensure(E.samples().size() == x.size());
+			ensure(std::is_sorted(E.samples().begin(), E.samples().end()));
+		}, 8);
+		assert(empirical<>::indexed(path));
+		for (const auto& e : std::filesystem::directory_iterator(path.parent_path())) {
+			auto name = e.path().filename().string();
+			assert(!(name.starts_with(path.filename().string()) and name.ends_with(".tmp")));
+		}
+	}
+	std::filesystem::remove(empirical<>::sidecar(path));
+	std::filesystem::remove(path);
+
+	return 0;
+}
+int test_variate_empirical_ = test_variate_empirical();
+
+// opening an indexed file only maps it, and the cost of cumulant and cdf on 4M samples
+int benchmark_variate_empirical()
+{
+	std::vector<double> x;
+	auto path = test_variate_empirical_file("fms_variate_empirical_benchmark.bin", 1 << 22, x);
+
+	double ms_index = test::report("empirical index ms", test::time([&]() { empirical<>{path}; }));
+	double ms_open = test::report("empirical open ms", test::time([&]() { empirical<>{path}; }));
+	assert(ms_open < ms_index / 10);
+
+	empirical<> E(path);
+	test::report("empirical cumulant ms", test::best(3, [&]() { E.cumulant(0.1, 4); }));
+	test::report("empirical cdf ms", test::best(3, [&]() { E.cdf(0., 0.2); }));
+
+	std::filesystem::remove(empirical<>::sidecar(path));
+	std::filesystem::remove(path);
+
+	return 0;
+}
+int benchmark_variate_empirical_ = benchmark_variate_empirical();
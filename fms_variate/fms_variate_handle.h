@@ -0,0 +1,167 @@
+// fms_variate_handle.h - Interface class for random variates.
+#pragma once
+#include <memory>
+#include <span>
+#include "fms_variate.h"
+
+namespace fms::variate {
+
+	// NVI base class for variates
+	// Every array member is one virtual call that runs the batch kernel of the model,
+	// or a loop over the concrete type the compiler can inline, so dispatch is paid once per array.
+	template<class X = double, class S = X>
+	struct variate_base {
+		typedef X xtype;
+		typedef S stype;
+
+		variate_base()
+		{ }
+		variate_base(const variate_base&) = delete;
+		variate_base& operator=(const variate_base&) = delete;
+		virtual ~variate_base()
+		{ }
+
+		// transformed cumulative distribution function and derivatives
+		X cdf(X x, S s = 0, unsigned n = 0) const
+		{
+			return cdf_(x, s, n);
+		}
+		// (d/ds)^n log E[exp(sX)]
+		S cumulant(S s, unsigned n = 0) const
+		{
+			return cumulant_(s, n);
+		}
+		X edf(S s, X x) const
+		{
+			return edf_(s, x);
+		}
+		// out[i] = cdf(x[i], s, n) in one call
+		void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+		{
+			cdf_(x, s, n, out);
+		}
+		// cdf(x, s, 0), ..., cdf(x, s, N) in one call
+		void cdf_jet(X x, S s, unsigned N, std::span<X> out) const
+		{
+			cdf_jet_(x, s, N, out);
+		}
+		// out[i] = cumulant(s[i], n) in one call
+		void cumulant(std::span<const S> s, unsigned n, std::span<S> out) const
+		{
+			cumulant_(s, n, out);
+		}
+		// cumulant(s, 0), ..., cumulant(s, N) in one call
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			cumulant_jet_(s, N, out);
+		}
+		// out[i] = edf(s, x[i]) in one call
+		void edf(S s, std::span<const X> x, std::span<X> out) const
+		{
+			edf_(s, x, out);
+		}
+		// smallest x with cdf(x, s) >= p
+		X quantile(X p, S s = 0) const
+		{
+			return quantile_(p, s);
+		}
+		// out[i] = quantile(p[i], s) in one call
+		void quantile(std::span<const X> p, S s, std::span<X> out) const
+		{
+			quantile_(p, s, out);
+		}
+		// new variate mu + sigma X holding a copy of the model with affine layers folded
+		std::unique_ptr<variate_base> location_scale(X mu, X sigma) const
+		{
+			return location_scale_(mu, sigma);
+		}
+		// new variate X_s holding a copy of the model with the state at s computed once
+		std::unique_ptr<variate_base> tilt(S s) const
+		{
+			return tilt_(s);
+		}
+	private:
+		virtual X cdf_(X x, S s, unsigned n) const = 0;
+		virtual void cdf_(std::span<const X> x, S s, unsigned n, std::span<X> out) const = 0;
+		virtual void cdf_jet_(X x, S s, unsigned N, std::span<X> out) const = 0;
+		virtual X quantile_(X p, S s) const = 0;
+		virtual void quantile_(std::span<const X> p, S s, std::span<X> out) const = 0;
+		virtual S cumulant_(S s, unsigned n) const = 0;
+		virtual void cumulant_(std::span<const S> s, unsigned n, std::span<S> out) const = 0;
+		virtual void cumulant_jet_(S s, unsigned N, std::span<S> out) const = 0;
+		virtual X edf_(S s, X x) const = 0;
+		virtual void edf_(S s, std::span<const X> x, std::span<X> out) const = 0;
+		virtual std::unique_ptr<variate_base> location_scale_(X mu, X sigma) const = 0;
+		virtual std::unique_ptr<variate_base> tilt_(S s) const = 0;
+	};
+
+	// implement for a specific variate model
+	template<class M, class X = typename M::xtype, class S = typename M::stype>
+		requires fms::variate_concept<M>
+	class variate_handle : public variate_base<X, S>
+	{
+		M m;
+	public:
+		variate_handle(const M& m)
+			: m(m)
+		{ }
+		variate_handle(const variate_handle&) = default;
+		variate_handle& operator=(const variate_handle&) = default;
+		~variate_handle()
+		{ }
+
+		X cdf_(X x, S s = 0, unsigned n = 0) const override
+		{
+			return m.cdf(x, s, n);
+		}
+		void cdf_(std::span<const X> x, S s, unsigned n, std::span<X> out) const override
+		{
+			fms::variate::cdf(m, x, s, n, out);
+		}
+		void cdf_jet_(X x, S s, unsigned N, std::span<X> out) const override
+		{
+			fms::variate::cdf_jet(m, x, s, N, out);
+		}
+		X quantile_(X p, S s) const override
+		{
+			return fms::variate::quantile(m, p, s);
+		}
+		void quantile_(std::span<const X> p, S s, std::span<X> out) const override
+		{
+			fms::variate::quantile(m, p, s, out);
+		}
+		S cumulant_(S s, unsigned n = 0) const override
+		{
+			return m.cumulant(s, n);
+		}
+		void cumulant_(std::span<const S> s, unsigned n, std::span<S> out) const override
+		{
+			fms::variate::cumulant(m, s, n, out);
+		}
+		void cumulant_jet_(S s, unsigned N, std::span<S> out) const override
+		{
+			fms::variate::cumulant_jet(m, s, N, out);
+		}
+		X edf_(S s, X x) const override
+		{
+			return m.edf(s, x);
+		}
+		void edf_(S s, std::span<const X> x, std::span<X> out) const override
+		{
+			fms::variate::edf(m, s, x, out);
+		}
+		std::unique_ptr<variate_base<X, S>> location_scale_(X mu, X sigma) const override
+		{
+			auto a = mu + sigma * m;
+
+			return std::unique_ptr<variate_base<X, S>>(new variate_handle<decltype(a), X, S>(a));
+		}
+		std::unique_ptr<variate_base<X, S>> tilt_(S s) const override
+		{
+			auto t = fms::variate::tilt(m, s);
+
+			return std::unique_ptr<variate_base<X, S>>(new variate_handle<decltype(t), X, S>(t));
+		}
+	};
+
+}
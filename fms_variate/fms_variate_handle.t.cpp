@@ -0,0 +1,119 @@
+// fms_variate_handle.t.cpp - test batch calls through variate_base
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+#include "fms_variate_handle.h"
+#include "fms_variate_logistic.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<variate_base<>>);
+static_assert(variate_batch_concept<variate_base<>>);
+static_assert(variate_edf_batch_concept<variate_base<>>);
+static_assert(variate_cumulant_batch_concept<variate_base<>>);
+
+template<class X>
+int test_variate_handle()
+{
+	std::vector<X> x = { X(-3), X(-0.5), X(0), X(0.25), X(2) };
+	std::vector<X> out(x.size());
+	{
+		std::unique_ptr<variate_base<X>> v(new variate_handle(logistic<X>(2, 3)));
+		const variate_base<X>& V = *v;
+
+		// batch calls are the same as scalar calls
+		for (X s : { X(-1), X(0), X(0.5) }) {
+			for (unsigned n = 0; n <= 2; ++n) {
+				V.cdf(x, s, n, out);
+				for (size_t i = 0; i < x.size(); ++i) {
+					assert(fabs(out[i] - V.cdf(x[i], s, n)) < 1e-15);
+				}
+			}
+			V.edf(s, x, out);
+			for (size_t i = 0; i < x.size(); ++i) {
+				assert(fabs(out[i] - V.edf(s, x[i])) < 1e-15);
+			}
+		}
+		std::vector<X> s = { X(-1.5), X(-0.5), X(0), X(1), X(2.5) };
+		for (unsigned n = 0; n <= 3; ++n) {
+			V.cumulant(s, n, out);
+			for (size_t i = 0; i < s.size(); ++i) {
+				assert(fabs(out[i] - V.cumulant(s[i], n)) < 1e-14 * std::max(X(1), fabs(out[i])));
+			}
+		}
+
+		// in place
+		out = x;
+		V.cdf(out, X(0.5), 0, out);
+		for (size_t i = 0; i < x.size(); ++i) {
+			assert(fabs(out[i] - V.cdf(x[i], X(0.5))) < 1e-15);
+		}
+	}
+	{
+		// location and scale fold into the affine held by the handle
+		std::unique_ptr<variate_base<X>> v(new variate_handle(affine(standard_normal<X>{}, X(1), X(2))));
+		auto w = v->location_scale(X(-0.5), X(0.5)); // -0.5 + 0.5(1 + 2 Z) = Z
+		for (X s : { X(-0.5), X(0), X(0.5) }) {
+			w->cdf(x, s, 0, out);
+			for (size_t i = 0; i < x.size(); ++i) {
+				assert(w->cdf(x[i], s) == standard_normal<X>::cdf(x[i], s));
+				assert(fabs(out[i] - w->cdf(x[i], s)) < 1e-15);
+			}
+			w->edf(s, x, out);
+			for (size_t i = 0; i < x.size(); ++i) {
+				assert(fabs(out[i] - w->edf(s, x[i])) < 1e-15);
+			}
+		}
+		assert(v->cumulant(X(0), 1) == 1);
+	}
+	{
+		// tilt of the model held by the handle
+		std::unique_ptr<variate_base<X>> v(new variate_handle(logistic<X>(2, 3)));
+		auto w = v->tilt(X(0.5));
+		auto u = w->location_scale(X(1), X(2))->tilt(X(-0.25)); // 1 + 2 X_0
+		for (X xi : x) {
+			assert(fabs(w->cdf(xi) - v->cdf(xi, X(0.5))) < 1e-15);
+			assert(fabs(w->cdf(xi, X(0.1), 2) - v->cdf(xi, X(0.6), 2)) < 1e-15);
+			assert(fabs(w->edf(X(0), xi) - v->edf(X(0.5), xi)) < 1e-12);
+			assert(fabs(u->cdf(1 + 2 * xi) - v->cdf(xi)) < 1e-15);
+		}
+		assert(w->cumulant(X(0)) == 0);
+	}
+
+	return 0;
+}
+int test_variate_handle_d = test_variate_handle<double>();
+
+// one virtual call per array instead of one per element
+int benchmark_variate_handle()
+{
+	random::philox g(3);
+	std::vector<double> x(1 << 16), out(x.size());
+	for (auto& xi : x) {
+		xi = random::normal(g);
+	}
+	std::unique_ptr<variate_base<>> v(new variate_handle(standard_normal<>{}));
+	const variate_base<>& V = *v;
+
+	double ms_scalar = test::time([&]() {
+		for (int k = 0; k < 100; ++k) {
+			for (size_t i = 0; i < x.size(); ++i) {
+				out[i] = V.cdf(x[i], 0.1);
+			}
+		}
+	});
+	double ms_batch = test::time([&]() {
+		for (int k = 0; k < 100; ++k) {
+			V.cdf(x, 0.1, 0, out);
+		}
+	});
+	assert(ms_batch < 2 * ms_scalar); // not horrible
+
+	return 0;
+}
+int benchmark_variate_handle_ = benchmark_variate_handle();
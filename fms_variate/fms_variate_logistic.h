@@ -1,12 +1,21 @@
 // fms_variate_logistic
 #pragma once
+#include <algorithm>
+#include <complex>
 #include <concepts>
 #include <initializer_list>
+#include <limits>
+#include <span>
+#include <vector>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_sf_gamma.h>
 #include <gsl/gsl_sf_psi.h>
 #include <gsl/gsl_sf_hyperg.h>
 #include "fms_ensure.h"
+#include "fms_variate.h"
+#include "fms_random.h"
+#include "fms_sf_beta.h"
+#include "fms_sf_gamma.h"
 #include "fms_sf_hypergeometric.h"
 
 namespace fms::variate {
@@ -41,6 +50,67 @@ namespace fms::variate {
 		}
 	}
 
+	// Triangle A_{n,k}, 0 <= k <= n, for fixed a and b built row by row using the recurrence.
+	template<class X = double>
+	class A_triangle {
+		X a, b;
+		unsigned N; // number of rows
+		std::vector<X> A; // row n starts at n(n + 1)/2
+	public:
+		A_triangle(X a = 1, X b = 1)
+			: a(a), b(b), N(1), A{ X(1) }
+		{ }
+
+		bool is(X a_, X b_) const
+		{
+			return a == a_ and b == b_;
+		}
+
+		// A_{n,0}, ..., A_{n,n} in O(n^2) the first time row n is requested
+		const X* row(unsigned n)
+		{
+			if (n >= N) {
+				A.resize((n + 1) * (n + 2) / 2);
+				for (; N <= n; ++N) {
+					const X* A_ = A.data() + (N - 1) * N / 2; // previous row
+					X* An = A.data() + N * (N + 1) / 2;
+					An[0] = -b * A_[0];
+					for (unsigned k = 1; k < N; ++k) {
+						An[k] = -(b + k) * A_[k] + (a + b + k - 1) * A_[k - 1];
+					}
+					An[N] = (a + b + N - 1) * A_[N - 1];
+				}
+			}
+
+			return A.data() + n * (n + 1) / 2;
+		}
+
+		// Triangle from a small per-thread cache keyed on (a, b).
+		// The reference is valid until the next call from the same thread.
+		static A_triangle& cached(X a, X b)
+		{
+			static constexpr size_t M = 4; // cache size
+			thread_local A_triangle cache[M];
+			thread_local size_t next = 0;
+
+			for (auto& t : cache) {
+				if (t.is(a, b)) {
+					return t;
+				}
+			}
+
+			A_triangle& t = cache[next];
+			next = (next + 1) % M;
+			t = A_triangle(a, b);
+
+			return t;
+		}
+		static const X* row(X a, X b, unsigned n)
+		{
+			return cached(a, b).row(n);
+		}
+	};
+
 #ifdef _DEBUG
 	template<class X>
 	inline void check_A(X a, X b)
@@ -92,11 +162,12 @@ Where \(B(\alpha,\beta)\) is the beta function.
 			}
 
 			unsigned n_ = n - 1;
+			const X* An = A_triangle<X>::row(a, b, n_);
 			X e_ = e_x / (1 + e_x);
 			X e_k = 1; // e_^k
 			X Ak = 0;
 			for (unsigned k = 0; k <= n_; ++k) {
-				Ak += A(a, b, n_, k) * e_k;
+				Ak += An[k] * e_k;
 				e_k *= e_;
 			}
 
@@ -112,9 +183,84 @@ Where \(B(\alpha,\beta)\) is the beta function.
 
 			return cdf0(a + s, b - s, x, n);
 		}
+		// out[i] = cdf(x[i], s, n), x and out may alias
+		// One log beta and one coefficient row for all x, then lanes of exp/log for double.
+		void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+		{
+			ensure(-a < s and s < b);
+			ensure(out.size() >= x.size());
+
+			X a_ = a + s, b_ = b - s;
+
+			if (n == 0) {
+				sf::beta_inc<X>(a_, b_).logit(x, out);
+
+				return;
+			}
+
+			cdfn(a_, b_, gsl_sf_lnbeta(a_, b_), n, x, out);
+		}
+		// out[i] = (d/dx)^n I_u(a, b) at x[i] for n > 0 given lnB = log B(a, b), x and out may alias
+		static void cdfn(X a_, X b_, X lnB, unsigned n, std::span<const X> x, std::span<X> out)
+		{
+			ensure(n > 0);
+			ensure(out.size() >= x.size());
+
+			if constexpr (std::is_same_v<X, double>) {
+				const X* An = A_triangle<X>::row(a_, b_, n - 1);
+				simd::transform(x, out, [a_, b_, n, An, lnB](auto x) {
+					using V = decltype(x);
+					V e = sf::lane::exp(-abs(x)); // e^{-|x|}
+					V l = sf::lane::log(V(1) + e);
+					// e_ = e^{-x}/(1 + e^{-x}) = 1 - u
+					V e_ = select(V(0) <= x, e, V(1)) / (V(1) + e);
+					V Ak(An[n - 1]);
+					for (unsigned k = n - 1; k-- > 0; ) {
+						Ak = fma(Ak, e_, V(An[k]));
+					}
+					// e^{-b x}/(1 + e^{-x})^{a + b} = u^a (1 - u)^b
+					V lnf = V(-a_) * (max(-x, V(0)) + l) - V(b_) * (max(x, V(0)) + l);
+
+					return sf::lane::exp(lnf - V(lnB)) * Ak;
+				});
+			}
+			else {
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = cdf0(a_, b_, x[i], n);
+				}
+			}
+		}
+		// cdf(x, s, 0), ..., cdf(x, s, N) using one exp, one beta, and one coefficient triangle
+		void cdf_jet(X x, S s, unsigned N, std::span<X> out) const
+		{
+			ensure(-a < s and s < b);
+
+			X a_ = a + s, b_ = b - s;
+			X e_x = exp(-x);
+
+			out[0] = gsl_sf_beta_inc(a_, b_, 1 / (1 + e_x));
+			if (N == 0) {
+				return;
+			}
+
+			auto& A_ = A_triangle<X>::cached(a_, b_);
+			A_.row(N - 1); // fill rows up to N - 1
+			X f = exp(-b_ * x) * pow(1 + e_x, -a_ - b_) / gsl_sf_beta(a_, b_);
+			X e_ = e_x / (1 + e_x);
+			for (unsigned n = 1; n <= N; ++n) {
+				const X* An = A_.row(n - 1);
+				X e_k = 1; // e_^k
+				X Ak = 0;
+				for (unsigned k = 0; k < n; ++k) {
+					Ak += An[k] * e_k;
+					e_k *= e_;
+				}
+				out[n] = f * Ak;
+			}
+		}
 		S cumulant(S s, unsigned n = 0) const
 		{
-			ensure(-1 < s and s < 1);
+			ensure(-a < s and s < b);
 
 			if (n == 0) {
 				return gsl_sf_lngamma(a + s) - gsl_sf_lngamma(a) 
@@ -125,13 +271,136 @@ Where \(B(\alpha,\beta)\) is the beta function.
 
 			return gsl_sf_psi_n(n_, a + s) + ((n_&1) ? 1 : -1) * gsl_sf_psi_n(n_, b - s);
 		}
+		// kappa(z) for complex z with -a < Re z < b up to a multiple of 2 pi i
+		std::complex<S> cumulant(std::complex<S> z) const
+		{
+			ensure(-a < z.real() and z.real() < b);
+
+			return sf::lngamma(a + z) + sf::lngamma(b - z) - (sf::lngamma<S>(a) + sf::lngamma<S>(b));
+		}
+
+		// kappa(s) = log Gamma(a + s) - log Gamma(a) + log Gamma(b - s) - log Gamma(b)
+		// kappa^{(n)}(s) = psi^{(n-1)}(a + s) + (-1)^n psi^{(n-1)}(b - s)
+		// out[i] = cumulant(s[i], n) with log Gamma(a) + log Gamma(b) computed once, s and out may alias
+		void cumulant(std::span<const S> s, unsigned n, std::span<S> out) const
+		{
+			ensure(out.size() >= s.size());
+
+			S lnab = n == 0 ? sf::lngamma<S>(a) + sf::lngamma<S>(b) : 0;
+			std::vector<S> ja(n + 1), jb(n + 1);
+			for (size_t i = 0; i < s.size(); ++i) {
+				ensure(-a < s[i] and s[i] < b);
+				sf::lngamma_jet<S>(a + s[i], n, ja);
+				sf::lngamma_jet<S>(b - s[i], n, jb);
+				out[i] = n == 0 ? ja[0] + jb[0] - lnab : ja[n] + ((n & 1) ? -1 : 1) * jb[n];
+			}
+		}
+		// cumulant(s, 0), ..., cumulant(s, N) from one log gamma jet at a + s and one at b - s
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			ensure(-a < s and s < b);
+			ensure(out.size() > N);
+
+			std::vector<S> jb(N + 1);
+			sf::lngamma_jet<S>(a + s, N, out);
+			sf::lngamma_jet<S>(b - s, N, jb);
+			out[0] = out[0] + jb[0] - (sf::lngamma<S>(a) + sf::lngamma<S>(b));
+			for (unsigned n = 1; n <= N; ++n) {
+				out[n] += ((n & 1) ? -1 : 1) * jb[n];
+			}
+		}
+
+		// Closed form when b - s = 1, F = u^{a + s}, or a + s = 1, F = 1 - (1 - u)^{b - s},
+		// where x = log(u/(1 - u)). Otherwise solve starting from the mean.
+		X quantile(X p, S s = 0) const
+		{
+			ensure(-a < s and s < b);
+			ensure(0 <= p and p <= 1);
+
+			if (p == 0) {
+				return -std::numeric_limits<X>::infinity();
+			}
+			if (p == 1) {
+				return std::numeric_limits<X>::infinity();
+			}
+
+			X a_ = a + s, b_ = b - s;
+			if (b_ == 1) {
+				X lu = log(p) / a_; // log u
+
+				return lu - log(-expm1(lu));
+			}
+			if (a_ == 1) {
+				X lv = log1p(-p) / b_; // log(1 - u)
+
+				return log(-expm1(lv)) - lv;
+			}
+
+			X sd = sqrt(cumulant(s, 2));
+
+			return quantile_solve(*this, p, s, cumulant(s, 1) + sd * normal_quantile_guess(p), sd);
+		}
+		// out[i] = quantile(p[i], s) warm starting from the previous root, p and out may alias
+		void quantile(std::span<const X> p, S s, std::span<X> out) const
+		{
+			ensure(-a < s and s < b);
+
+			if (a + s == 1 or b - s == 1) {
+				ensure(out.size() >= p.size());
+				for (size_t i = 0; i < p.size(); ++i) {
+					out[i] = quantile(p[i], s);
+				}
+			}
+			else {
+				quantile_warm(*this, p, s, out);
+			}
+		}
+
+		// X_s is logistic(a + s, b - s) and u = 1/(1 + e^{-X}) is Beta(a, b) so X = log G_a/G_b
+		// for independent Gamma(a) and Gamma(b) draws. Invert U when a + s = 1 or b - s = 1.
+		template<std::uniform_random_bit_generator G>
+		void sample(G& g, std::span<X> out, S s = 0) const
+		{
+			ensure(-a < s and s < b);
+
+			X a_ = a + s, b_ = b - s;
+			if (a_ == 1 and b_ == 1) {
+				for (auto& x : out) {
+					X u = X(random::uniform(g));
+					x = log(u) - log1p(-u);
+				}
+			}
+			else if (a_ == 1 or b_ == 1) {
+				for (auto& x : out) {
+					x = quantile(X(random::uniform(g)), s);
+				}
+			}
+			else {
+				random::log_gamma Ga(a_), Gb(b_);
+				for (auto& x : out) {
+					x = X(Ga(g) - Gb(g));
+				}
+			}
+		}
 
-		// d/ds F_s(a,b;x) = d/ds F(a + s, b - s; x) = F_s(a + s, b - s; x) log u(1 - u)
+		// d/ds F_s(x) = d/ds I_u(a + s, b - s) where u = 1/(1 + e^{-x})
+		// using the fourth order central difference (8(F(h) - F(-h)) - (F(2h) - F(-2h)))/12h
 		X edf(S s, X x) const
 		{
+			ensure(-a < s and s < b);
+
+			S h = edf_step(s);
 			X u = 1 / (1 + exp(-x));
+			auto F = [&](S k) { return gsl_sf_beta_inc(a + s + k * h, b - s - k * h, u); };
+
+			return (8 * (F(1) - F(-1)) - (F(2) - F(-2))) / X(12 * h);
+		}
+		// step used by edf that keeps s +- 2h inside (-a, b)
+		S edf_step(S s) const
+		{
+			static const S h = std::pow(std::numeric_limits<S>::epsilon(), S(0.2));
 
-			return log(u * (1 - u)) * cdf0(a + s, b - s, x);
+			return std::min({ h * std::max(S(1), fabs(s)), (a + s) / 4, (b - s) / 4 });
 		}
 		
 		static X beta(X a, X b)
@@ -172,4 +441,171 @@ Where \(B(\alpha,\beta)\) is the beta function.
 		
 	};
 
+	// X_s of logistic(a, b) is logistic(a + s, b - s). The incomplete beta functions used by
+	// cdf and edf, log B(a + s, b - s), and log Gamma(a + s) + log Gamma(b - s) are computed once.
+	template<class X, class S>
+	class tilted<logistic<X, S>, X, S> {
+		logistic<X, S> v;
+		S s;
+		X a_, b_; // a + s, b - s
+		X lnB; // log B(a_, b_)
+		S lnG; // log Gamma(a_) + log Gamma(b_)
+		S h; // edf step
+		std::vector<sf::beta_inc<X>> I; // I_u(a_ + kh, b_ - kh) for k = -2, ..., 2
+
+		// out[i] = I_u(a_ + kh, b_ - kh) - I_u(a_ - kh, b_ + kh), x and out may alias
+		void difference(int k, std::span<const X> x, std::span<X> out) const
+		{
+			std::vector<X> F(x.size());
+			I[2 - k].logit(x, F);
+			I[2 + k].logit(x, out);
+			for (size_t i = 0; i < x.size(); ++i) {
+				out[i] -= F[i];
+			}
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		tilted(const logistic<X, S>& v, S s)
+			: v(v), s(s), a_(v.a + s), b_(v.b - s), lnB(0), lnG(0), h(0)
+		{
+			ensure(-v.a < s and s < v.b);
+
+			lnB = gsl_sf_lnbeta(a_, b_);
+			lnG = sf::lngamma<S>(a_) + sf::lngamma<S>(b_);
+			h = v.edf_step(s);
+			I.reserve(5);
+			for (int k = -2; k <= 2; ++k) {
+				I.emplace_back(a_ + k * h, b_ - k * h);
+			}
+		}
+		tilted(const tilted&) = default;
+		tilted& operator=(const tilted&) = default;
+		~tilted()
+		{ }
+
+		const logistic<X, S>& base() const
+		{
+			return v;
+		}
+		S parameter() const
+		{
+			return s;
+		}
+
+		X cdf(X x, S t = 0, unsigned n = 0) const
+		{
+			if (t != 0) {
+				return v.cdf(x, s + t, n);
+			}
+
+			if (n == 0) {
+				return I[2].logit(x);
+			}
+
+			X e_x = exp(-x);
+			const X* An = A_triangle<X>::row(a_, b_, n - 1);
+			X e_ = e_x / (1 + e_x);
+			X Ak = An[n - 1];
+			for (unsigned k = n - 1; k-- > 0; ) {
+				Ak = Ak * e_ + An[k];
+			}
+
+			return exp(-b_ * x - (a_ + b_) * log1p(e_x) - lnB) * Ak;
+		}
+		void cdf(std::span<const X> x, S t, unsigned n, std::span<X> out) const
+		{
+			ensure(out.size() >= x.size());
+
+			if (t != 0) {
+				v.cdf(x, s + t, n, out);
+			}
+			else if (n == 0) {
+				I[2].logit(x, out);
+			}
+			else {
+				logistic<X, S>::cdfn(a_, b_, lnB, n, x, out);
+			}
+		}
+		void cdf_jet(X x, S t, unsigned N, std::span<X> out) const
+		{
+			v.cdf_jet(x, s + t, N, out);
+		}
+
+		// log Gamma(a_ + t) + log Gamma(b_ - t) - log Gamma(a_) - log Gamma(b_)
+		S cumulant(S t, unsigned n = 0) const
+		{
+			if (n == 0) {
+				ensure(-a_ < t and t < b_);
+
+				return t == 0 ? 0 : sf::lngamma<S>(a_ + t) + sf::lngamma<S>(b_ - t) - lnG;
+			}
+
+			return v.cumulant(s + t, n);
+		}
+		std::complex<S> cumulant(std::complex<S> z) const
+		{
+			ensure(-a_ < z.real() and z.real() < b_);
+
+			return sf::lngamma(a_ + z) + sf::lngamma(b_ - z) - lnG;
+		}
+		void cumulant_jet(S t, unsigned N, std::span<S> out) const
+		{
+			ensure(-a_ < t and t < b_);
+			ensure(out.size() > N);
+
+			std::vector<S> jb(N + 1);
+			sf::lngamma_jet<S>(a_ + t, N, out);
+			sf::lngamma_jet<S>(b_ - t, N, jb);
+			out[0] = out[0] + jb[0] - lnG;
+			for (unsigned n = 1; n <= N; ++n) {
+				out[n] += ((n & 1) ? -1 : 1) * jb[n];
+			}
+		}
+
+		// same difference as logistic::edf with the incomplete beta functions precomputed
+		X edf(S t, X x) const
+		{
+			if (t != 0) {
+				return v.edf(s + t, x);
+			}
+
+			return (8 * (I[3].logit(x) - I[1].logit(x)) - (I[4].logit(x) - I[0].logit(x))) / X(12 * h);
+		}
+		void edf(S t, std::span<const X> x, std::span<X> out) const
+		{
+			ensure(out.size() >= x.size());
+
+			if (t != 0) {
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = v.edf(s + t, x[i]);
+				}
+			}
+			else {
+				std::vector<X> D2(x.size());
+				difference(2, x, D2);
+				difference(1, x, out);
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = (8 * out[i] - D2[i]) / X(12 * h);
+				}
+			}
+		}
+
+		X quantile(X p, S t = 0) const
+		{
+			return v.quantile(p, s + t);
+		}
+		void quantile(std::span<const X> p, S t, std::span<X> out) const
+		{
+			v.quantile(p, s + t, out);
+		}
+
+		template<std::uniform_random_bit_generator G>
+		void sample(G& g, std::span<X> out, S t = 0) const
+		{
+			v.sample(g, out, s + t);
+		}
+	};
+
 }
@@ -1,7 +1,15 @@
 // fms_variate_logistic.t.cpp - test logistic variate
 #include <cassert>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
 #include "fms_test.h"
+#include "fms_simd.h"
+#include "fms_variate.h"
+#include "fms_variate_sample.h"
 #include "fms_variate_logistic.h"
+#include "fms_variate_normal.h"
 
 using namespace fms::test;
 using namespace fms::variate;
@@ -18,6 +26,368 @@ int test_variate_logistic_A()
 }
 int test_variate_logistic_A_d = test_variate_logistic_A<double>();
 
+template<class X>
+int test_variate_logistic_A_triangle()
+{
+	for (auto a : { (X)0.9, (X)1.0, (X)1.1 }) {
+		for (auto b : { (X)0.9, (X)1.0, (X)1.1 }) {
+			A_triangle<X> t(a, b);
+			for (unsigned n : {3u, 0u, 1u, 5u, 2u}) {
+				const X* An = t.row(n);
+				for (unsigned k = 0; k <= n; ++k) {
+					X Ank = A(a, b, n, k);
+					assert(fabs(An[k] - Ank) <= 1e-12 * std::max(X(1), fabs(Ank)));
+				}
+				assert(A_triangle<X>::row(a, b, n)[n] == An[n]);
+			}
+		}
+	}
+
+	return 0;
+}
+int test_variate_logistic_A_triangle_d = test_variate_logistic_A_triangle<double>();
+
+// per call cost of cdf(x, s, n) in milliseconds using the triangle and the recursion
+template<class X>
+int benchmark_variate_logistic_A()
+{
+	logistic<X> v;
+	X s = X(0.1);
+	auto xs = range<X>(-2, 2, X(0.25));
+	constexpr unsigned N = 11;
+	double ms[N] = { 0 }, ms_[N] = { 0 };
+
+	for (unsigned n = 1; n < N; ++n) {
+		X a = 1 + s, b = 1 - s;
+		X sum = 0, sum_ = 0;
+		ms[n] = best(5, [&]() {
+			for (X x : xs) {
+				sum += v.cdf(x, s, n);
+			}
+		}) / xs.size();
+		ms_[n] = best(5, [&]() {
+			for (X x : xs) {
+				X e_x = exp(-x), e_ = e_x / (1 + e_x), e_k = 1, Ak = 0;
+				for (unsigned k = 0; k < n; ++k) {
+					Ak += A(a, b, n - 1, k) * e_k;
+					e_k *= e_;
+				}
+				sum_ += exp(-b * x) * pow(1 + e_x, -a - b) * Ak / logistic<X>::beta(a, b);
+			}
+		}) / xs.size();
+		assert(fabs(sum - sum_) <= 1e-8 * std::max(X(1), fabs(sum)));
+		report("logistic cdf triangle ms n=" + std::to_string(n), ms[n]);
+		report("logistic cdf recursion ms n=" + std::to_string(n), ms_[n]);
+	}
+	// recursion is exponential in n
+	assert(ms[N - 1] < ms_[N - 1]);
+
+	return 0;
+}
+int benchmark_variate_logistic_A_d = benchmark_variate_logistic_A<double>();
+
+template<class X>
+int test_variate_logistic_batch()
+{
+	auto x = range<X>(-40, 40, X(0.01));
+	const size_t m = x.size();
+	std::vector<X> y(m);
+
+	for (X a : {X(0.5), X(1), X(3)}) {
+		logistic<X> v(a, X(1.5));
+		for (X s : {X(-0.2), X(0), X(0.4)}) {
+			for (unsigned n = 0; n <= 4; ++n) {
+				cdf(v, std::span<const X>(&x[0], m), s, n, std::span<X>(y));
+				X ymax = 0;
+				for (X yi : y) {
+					ymax = std::max(ymax, fabs(yi));
+				}
+				for (size_t i = 0; i < m; ++i) {
+					X cn = v.cdf(x[i], s, n);
+					// derivatives cancel near their roots
+					X tol = 1e-12 * std::max(fabs(cn), X(1e-280)) + (n ? 1e-14 * ymax : 0);
+					assert(fabs(y[i] - cn) <= tol);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+int test_variate_logistic_batch_d = test_variate_logistic_batch<double>();
+
+// milliseconds per x for scalar and batch cdf
+template<class X>
+int benchmark_variate_logistic_batch()
+{
+	logistic<X> v(X(2), X(1.5));
+	auto x = range<X>(-10, 10, X(0.001));
+	const size_t m = x.size();
+	std::vector<X> y(m);
+	constexpr unsigned N = 4;
+	double ms[N] = { 0 }, ms_batch[N] = { 0 };
+	X sum = 0;
+
+	for (unsigned n = 0; n < N; ++n) {
+		ms[n] = time([&]() {
+			for (X xi : x) {
+				sum += v.cdf(xi, X(0.1), n);
+			}
+		}) / m;
+		ms_batch[n] = time([&]() {
+			v.cdf(std::span<const X>(&x[0], m), X(0.1), n, std::span<X>(y));
+		}) / m;
+	}
+	if (fms::simd::best() == fms::simd::level::scalar) {
+		assert(ms_batch[N - 1] < 4 * ms[N - 1]); // not horrible without SIMD
+	}
+	else {
+		assert(ms_batch[N - 1] < ms[N - 1]);
+	}
+
+	return sum != 0;
+}
+int benchmark_variate_logistic_batch_d = benchmark_variate_logistic_batch<double>();
+
+template<class X>
+int test_variate_logistic_cumulant_batch()
+{
+	constexpr unsigned N = 6;
+	X jet[N + 1];
+
+	for (X a : {X(0.5), X(2)}) {
+		logistic<X> v(a, X(1.5));
+		auto s = range<X>(X(0.01) - a, X(1.49), X(0.01));
+		const size_t m = s.size();
+		std::vector<X> k(m);
+		for (unsigned n = 0; n <= N; ++n) {
+			cumulant(v, std::span<const X>(&s[0], m), n, std::span<X>(k));
+			for (size_t i = 0; i < m; ++i) {
+				X kn = v.cumulant(s[i], n);
+				assert(fabs(k[i] - kn) <= 1e-13 * std::max(X(1), fabs(kn)));
+			}
+		}
+		for (size_t i = 0; i < m; i += 7) {
+			cumulant_jet(v, s[i], N, std::span<X>(jet));
+			for (unsigned n = 0; n <= N; ++n) {
+				X kn = v.cumulant(s[i], n);
+				assert(fabs(jet[n] - kn) <= 1e-13 * std::max(X(1), fabs(kn)));
+			}
+		}
+		cumulant_jet(v, X(0), N, std::span<X>(jet));
+		assert(jet[0] == 0);
+	}
+	{
+		logistic<X> v(X(2), X(1.5));
+		affine<logistic<X>> w(v, X(0.5), X(2));
+		X s[] = { X(-0.9), X(0), X(0.7) };
+		X k[3];
+		for (unsigned n = 0; n <= 3; ++n) {
+			cumulant(w, std::span<const X>(s), n, std::span<X>(k));
+			for (size_t i = 0; i < 3; ++i) {
+				X kn = w.cumulant(s[i], n);
+				assert(fabs(k[i] - kn) <= 1e-13 * std::max(X(1), fabs(kn)));
+			}
+		}
+		cumulant_jet(w, X(0.3), 3, std::span<X>(jet));
+		for (unsigned n = 0; n <= 3; ++n) {
+			X kn = w.cumulant(X(0.3), n);
+			assert(fabs(jet[n] - kn) <= 1e-13 * std::max(X(1), fabs(kn)));
+		}
+	}
+
+	return 0;
+}
+int test_variate_logistic_cumulant_batch_d = test_variate_logistic_cumulant_batch<double>();
+
+// milliseconds per s for cumulant(s, n), the batch, and the jet of orders 0, ..., N
+template<class X>
+int benchmark_variate_logistic_cumulant()
+{
+	logistic<X> v(X(2), X(1.5));
+	auto s = range<X>(-1.5, 1.4, X(0.001));
+	const size_t m = s.size();
+	std::vector<X> k(m);
+	constexpr unsigned N = 4;
+	X jet[N + 1];
+	X sum = 0;
+
+	double ms = best(5, [&]() {
+		for (unsigned n = 0; n <= N; ++n) {
+			for (X si : s) {
+				sum += v.cumulant(si, n);
+			}
+		}
+	}) / m;
+	double ms_batch = best(5, [&]() {
+		for (unsigned n = 0; n <= N; ++n) {
+			v.cumulant(std::span<const X>(&s[0], m), n, std::span<X>(k));
+		}
+	}) / m;
+	double ms_jet = best(5, [&]() {
+		for (X si : s) {
+			v.cumulant_jet(si, N, std::span<X>(jet));
+		}
+	}) / m;
+
+	report("logistic cumulant scalar ms", ms);
+	report("logistic cumulant batch ms", ms_batch);
+	report("logistic cumulant jet ms", ms_jet);
+	// all orders at once
+	assert(ms_jet < ms); // not horrible
+
+	return sum != 0;
+}
+int benchmark_variate_logistic_cumulant_d = benchmark_variate_logistic_cumulant<double>();
+
+template<class X>
+int test_variate_logistic_quantile()
+{
+	// closed forms
+	for (X a : {X(0.5), X(1), X(3)}) {
+		logistic<X> v(a, 1);
+		logistic<X> w(1, a);
+		for (X p : {X(1e-12), X(0.01), X(0.5), X(0.9), X(1 - 1e-9)}) {
+			X x = v.quantile(p);
+			assert(fabs(v.cdf(x) - p) <= 1e-14 * p);
+			x = w.quantile(p);
+			// 1 - F(x) = (1 + e^x)^{-a} is accurate in the upper tail
+			assert(fabs(pow(1 + exp(x), -a) - (1 - p)) <= 1e-14 * (1 - p));
+		}
+	}
+	assert(logistic<X>().quantile(X(0.5)) == 0);
+	assert(logistic<X>(2, 1.5).quantile(X(0.75), X(-1)) == logistic<X>(1, 2.5).quantile(X(0.75)));
+
+	// generic solver
+	for (X a : {X(0.5), X(2)}) {
+		logistic<X> v(a, 1.5);
+		for (X s : {X(-0.2), X(0.3)}) {
+			for (X p : {X(1e-10), X(0.01), X(0.5), X(0.9), X(0.999)}) {
+				X x = v.quantile(p, s);
+				assert(fabs(v.cdf(x, s) - p) <= 1e-13 * p);
+			}
+		}
+	}
+
+	// warm start matches cold start
+	{
+		logistic<X> v(2, 1.5);
+		auto p = range<X>(X(0.001), X(0.999), X(0.001));
+		const size_t m = p.size();
+		std::vector<X> x(m);
+		quantile(v, std::span<const X>(&p[0], m), X(0.1), std::span<X>(x));
+		for (size_t i = 0; i < m; i += 17) {
+			assert(fabs(x[i] - v.quantile(p[i], X(0.1))) <= 1e-12 * std::max(X(1), fabs(x[i])));
+		}
+	}
+
+	return 0;
+}
+int test_variate_logistic_quantile_d = test_variate_logistic_quantile<double>();
+
+// milliseconds per p for cold and warm started quantiles
+template<class X>
+int benchmark_variate_logistic_quantile()
+{
+	logistic<X> v(2, 1.5);
+	auto p = range<X>(X(0.0005), X(0.9995), X(0.0005));
+	const size_t m = p.size();
+	std::vector<X> x(m);
+	X sum = 0;
+
+	double ms = best(5, [&]() {
+		for (X pi : p) {
+			sum += v.quantile(pi, X(0.1));
+		}
+	}) / m;
+	double ms_warm = best(5, [&]() {
+		quantile(v, std::span<const X>(&p[0], m), X(0.1), std::span<X>(x));
+	}) / m;
+	report("logistic quantile cold ms", ms);
+	report("logistic quantile warm ms", ms_warm);
+	assert(ms_warm < 2 * ms); // not horrible
+
+	return sum != 0;
+}
+int benchmark_variate_logistic_quantile_d = benchmark_variate_logistic_quantile<double>();
+
+// Kolmogorov-Smirnov statistic of draws against cdf(x, s)
+template<class V, class X>
+inline X ks(const V& v, std::vector<X>& x, X s)
+{
+	std::sort(x.begin(), x.end());
+	X D = 0, n = X(x.size());
+	for (size_t i = 0; i < x.size(); ++i) {
+		X F = v.cdf(x[i], s);
+		D = std::max({ D, fabs(F - i / n), fabs((i + 1) / n - F) });
+	}
+
+	return D;
+}
+
+template<class X>
+int test_variate_logistic_sample()
+{
+	std::mt19937_64 r(42);
+	std::vector<X> x(100'000);
+	X D_max = X(1.95) / sqrt(X(x.size())); // 0.1% critical value
+
+	for (X a : {X(0.5), X(1), X(2)}) {
+		for (X b : {X(1), X(1.5)}) {
+			logistic<X> v(a, b);
+			for (X s : {X(0), X(-0.3), X(0.4)}) {
+				sample(v, r, std::span<X>(x), s);
+				assert(ks(v, x, s) < D_max);
+			}
+		}
+	}
+	{
+		logistic<X> v(2, 1.5);
+		affine<logistic<X>> w(v, 1, 3);
+		sample(w, r, std::span<X>(x), X(0.1));
+		assert(ks(w, x, X(0.1)) < D_max);
+	}
+
+	return 0;
+}
+int test_variate_logistic_sample_d = test_variate_logistic_sample<double>();
+
+// samples per second using the inverse cdf (a = b = 1) and a ratio of gamma draws
+template<class X>
+int benchmark_variate_logistic_sample()
+{
+	std::mt19937_64 r(0);
+	std::vector<X> x(1'000'000);
+	double per_sec[2];
+	size_t i = 0;
+
+	for (X a : {X(1), X(2.5)}) {
+		logistic<X> v(a, a);
+		per_sec[i++] = 1000 * x.size() / time([&]() { v.sample(r, std::span<X>(x)); });
+	}
+
+	return per_sec[0] > 0 and per_sec[1] > 0;
+}
+int benchmark_variate_logistic_sample_d = benchmark_variate_logistic_sample<double>();
+
+template<class X>
+int test_variate_logistic_cumulant_solve()
+{
+	logistic<X> L(2, 1.5);
+	// kappa'(s) -> infinity as s -> b so Newton steps overshoot the domain
+	for (X x : { X(-20), X(-1), X(0), X(0.5), X(3), X(40) }) {
+		X s = cumulant_solve(L, x);
+		assert(-2 < s and s < 1.5);
+		assert(fabs(L.cumulant(s, 1) - x) <= 1e-13 * std::max(X(1), fabs(x)) * L.cumulant(s, 2));
+	}
+	// warm start
+	X s = cumulant_solve(L, X(3), X(1));
+	assert(fabs(L.cumulant(s, 1) - 3) < 1e-12);
+
+	return 0;
+}
+int test_variate_logistic_cumulant_solve_d = test_variate_logistic_cumulant_solve<double>();
+
 template<class X>
 int test_variate_logistic()
 {
@@ -33,6 +403,23 @@ int test_variate_logistic()
 		df = (dp - dm) / (2 * h);
 		df -= f1;
 	}
+	{
+		constexpr unsigned N = 8;
+		X jet[N + 1];
+
+		for (X a : {X(0.5), X(1), X(2)}) {
+			logistic<X> v(a, 1.5);
+			for (X s : {X(-0.1), X(0), X(0.2)}) {
+				for (X x : {X(-2), X(0), X(0.5), X(3)}) {
+					cdf_jet(v, x, s, N, std::span<X>(jet));
+					for (unsigned n = 0; n <= N; ++n) {
+						X cn = v.cdf(x, s, n);
+						assert(fabs(jet[n] - cn) <= 1e-12 * std::max(X(1), fabs(cn)));
+					}
+				}
+			}
+		}
+	}
 	{
 		logistic<X> v;
 
@@ -92,4 +479,103 @@ int test_variate_logistic()
 
 	return 0;
 }
-int test_variate_logistic_d = test_variate_logistic<double>();
\ No newline at end of file
+int test_variate_logistic_d = test_variate_logistic<double>();
+// edf is the partial expectation E[1(X_s <= x)(X_s - kappa'(s))]
+template<class X>
+int test_variate_logistic_edf()
+{
+	logistic<X> v(X(2), X(1.5));
+	for (X s : { X(-0.5), X(0), X(0.7) }) {
+		X k1 = v.cumulant(s, 1);
+		for (X x : { X(-3), X(0), X(0.5), X(4) }) {
+			// Simpson's rule on [x - 60, x]
+			size_t n = 60'000;
+			X h = X(60) / n;
+			auto f = [&](X t) { return (t - k1) * v.cdf(t, s, 1); };
+			X I = f(x - 60) + f(x);
+			for (size_t i = 1; i < n; ++i) {
+				I += (i & 1 ? 4 : 2) * f(x - 60 + i * h);
+			}
+			I *= h / 3;
+			assert(fabs(v.edf(s, x) - I) < 1e-11);
+		}
+	}
+
+	return 0;
+}
+int test_variate_logistic_edf_d = test_variate_logistic_edf<double>();
+
+template<class X>
+int test_variate_logistic_tilt()
+{
+	logistic<X> v(X(2), X(1.5));
+	std::vector<X> x = { X(-5), X(-1), X(0), X(0.3), X(2), X(8) };
+	std::vector<X> out(x.size());
+	for (X s : { X(-1), X(0), X(0.4) }) {
+		auto w = tilt(v, s);
+		static_assert(std::is_same_v<decltype(w), tilted<logistic<X>>>);
+		assert(w.cumulant(0) == 0);
+		assert(fabs(w.cumulant(X(0.2)) - (v.cumulant(s + X(0.2)) - v.cumulant(s))) < 1e-14);
+		assert(w.cumulant(X(0.2), 2) == v.cumulant(s + X(0.2), 2));
+		for (unsigned n = 0; n <= 3; ++n) {
+			w.cdf(x, 0, n, out);
+			for (size_t i = 0; i < x.size(); ++i) {
+				assert(fabs(out[i] - w.cdf(x[i], 0, n)) < 1e-15);
+				assert(fabs(out[i] - v.cdf(x[i], s, n)) < 1e-14);
+			}
+		}
+		// the difference quotient in s amplifies the ulp gap between SIMD and scalar lanes
+		w.edf(0, x, out);
+		for (size_t i = 0; i < x.size(); ++i) {
+			assert(fabs(out[i] - w.edf(0, x[i])) < 1e-12 * std::max(X(1), fabs(out[i])));
+			assert(fabs(out[i] - v.edf(s, x[i])) < 1e-12 * std::max(X(1), fabs(out[i])));
+		}
+		assert(w.cdf(X(1), X(0.1)) == v.cdf(X(1), s + X(0.1)));
+		assert(w.quantile(X(0.3)) == v.quantile(X(0.3), s));
+	}
+	{
+		// tilts fold through affine transformations and repeated tilts
+		auto A = 2 * v + 1;
+		auto B = tilt(tilt(A, X(0.1)), X(0.2));
+		static_assert(std::is_same_v<decltype(B), affine<tilted<logistic<X>>>>);
+		assert(fabs(B.base().parameter() - X(0.6)) < 1e-15);
+		for (X xi : x) {
+			assert(fabs(B.cdf(xi) - A.cdf(xi, X(0.3))) < 1e-14);
+		}
+
+		// generic tilt caches the cumulant
+		standard_normal<X> N;
+		auto C = tilt(N, X(0.5));
+		static_assert(std::is_same_v<decltype(C), tilted<standard_normal<X>>>);
+		assert(C.cdf(X(1)) == N.cdf(X(1), X(0.5)));
+		assert(C.cumulant(X(0.5)) == N.cumulant(X(1)) - N.cumulant(X(0.5)));
+	}
+
+	return 0;
+}
+int test_variate_logistic_tilt_d = test_variate_logistic_tilt<double>();
+
+// fixed s sweeping x
+template<class X>
+int benchmark_variate_logistic_tilt()
+{
+	logistic<X> v(X(2), X(1.5));
+	auto x = range<X>(-10, 10, X(0.001));
+	X s = X(0.1), sum = 0;
+
+	double ms = time([&]() {
+		for (X xi : x) {
+			sum += v.cdf(xi, s, 1) + v.edf(s, xi);
+		}
+	});
+	auto w = tilt(v, s);
+	double ms_tilt = time([&]() {
+		for (X xi : x) {
+			sum += w.cdf(xi, 0, 1) + w.edf(0, xi);
+		}
+	});
+	assert(ms_tilt < ms); // not horrible
+
+	return sum != 0;
+}
+int benchmark_variate_logistic_tilt_d = benchmark_variate_logistic_tilt<double>();
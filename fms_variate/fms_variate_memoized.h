@@ -0,0 +1,245 @@
+// fms_variate_memoized.h - cache results of repeated calls to a variate
+#pragma once
+#include <atomic>
+#include <bit>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_variate.h"
+#include "fms_variate_sample.h"
+
+namespace fms::variate {
+
+	static inline const char memoized_doc[] = R"xyzyx(
+Cache the values of <code>cdf(x, s, n)</code>, <code>cumulant(s, n)</code>, <code>edf(s, x)</code>, and
+<code>quantile(p, s)</code> keyed on the bit patterns of the arguments.
+The cache is a fixed size direct mapped table where each slot is guarded by a sequence counter,
+so readers never block and a writer that finds a slot busy does not cache its result.
+Hits and misses are counted in shards taken by threads in turn so lookups do not share a counter.
+Copies share the cache.
+)xyzyx";
+	template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+	class memoized {
+		static_assert(sizeof(X) == sizeof(uint64_t) and sizeof(S) == sizeof(uint64_t));
+
+		enum op : uint64_t { CDF = 1, CUMULANT, EDF, QUANTILE };
+
+		// odd seq while a writer updates the slot
+		struct alignas(64) slot {
+			std::atomic<uint64_t> seq{ 0 };
+			std::atomic<uint64_t> k0{ 0 }, k1{ 0 }, k2{ 0 };
+			std::atomic<uint64_t> value{ 0 };
+		};
+		// hit and miss counts of the threads assigned to a shard
+		struct alignas(64) counter {
+			std::atomic<uint64_t> hits{ 0 }, misses{ 0 };
+		};
+		static constexpr size_t shards = 16;
+		struct cache {
+			std::vector<slot> table;
+			uint64_t mask;
+			counter counts[shards]; // on their own lines so counting does not contend with lookups
+
+			cache(size_t n)
+				: table(n), mask(n - 1)
+			{ }
+
+			// threads take shards in turn
+			counter& shard()
+			{
+				static std::atomic<size_t> threads{ 0 };
+				thread_local size_t i = threads.fetch_add(1, std::memory_order_relaxed) % shards;
+
+				return counts[i];
+			}
+			uint64_t hits() const
+			{
+				uint64_t n = 0;
+				for (const auto& c : counts) {
+					n += c.hits.load(std::memory_order_relaxed);
+				}
+
+				return n;
+			}
+			uint64_t misses() const
+			{
+				uint64_t n = 0;
+				for (const auto& c : counts) {
+					n += c.misses.load(std::memory_order_relaxed);
+				}
+
+				return n;
+			}
+
+			// the low bits of doubles like 0.5 are all zero so every bit needs to be mixed
+			static uint64_t mix(uint64_t h)
+			{
+				h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDull;
+				h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ull;
+
+				return h ^ (h >> 33);
+			}
+			slot& at(uint64_t k0, uint64_t k1, uint64_t k2)
+			{
+				return table[mix(k1 ^ mix(k2 ^ k0)) & mask];
+			}
+
+			bool find(uint64_t k0, uint64_t k1, uint64_t k2, uint64_t& v)
+			{
+				slot& e = at(k0, k1, k2);
+				uint64_t s = e.seq.load(std::memory_order_acquire);
+				bool found = false;
+				if (!(s & 1)) {
+					found = e.k0.load(std::memory_order_relaxed) == k0
+						and e.k1.load(std::memory_order_relaxed) == k1
+						and e.k2.load(std::memory_order_relaxed) == k2;
+					v = e.value.load(std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_acquire);
+					found = found and e.seq.load(std::memory_order_relaxed) == s;
+				}
+				counter& n = shard();
+				(found ? n.hits : n.misses).fetch_add(1, std::memory_order_relaxed);
+
+				return found;
+			}
+
+			void store(uint64_t k0, uint64_t k1, uint64_t k2, uint64_t v)
+			{
+				slot& e = at(k0, k1, k2);
+				uint64_t s = e.seq.load(std::memory_order_relaxed);
+				if ((s & 1) or !e.seq.compare_exchange_strong(s, s + 1, std::memory_order_acq_rel)) {
+					return; // another writer has the slot
+				}
+				std::atomic_thread_fence(std::memory_order_release);
+				e.k0.store(k0, std::memory_order_relaxed);
+				e.k1.store(k1, std::memory_order_relaxed);
+				e.k2.store(k2, std::memory_order_relaxed);
+				e.value.store(v, std::memory_order_relaxed);
+				e.seq.store(s + 2, std::memory_order_release);
+			}
+		};
+
+		V v;
+		std::shared_ptr<cache> c;
+
+		template<class T>
+		static uint64_t bits(T t)
+		{
+			return std::bit_cast<uint64_t>(t);
+		}
+
+		// f() if (o, n, a, b) is not in the cache
+		template<class T, class F>
+		T memo(op o, unsigned n, uint64_t a, uint64_t b, const F& f) const
+		{
+			uint64_t k0 = (uint64_t(o) << 32) | n, u;
+			if (c->find(k0, a, b, u)) {
+				return std::bit_cast<T>(u);
+			}
+			T t = f();
+			c->store(k0, a, b, bits(t));
+
+			return t;
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// cache with at least capacity slots
+		memoized(const V& v, size_t capacity = 1 << 12)
+			: v(v), c(std::make_shared<cache>(std::bit_ceil(std::max<size_t>(capacity, 2))))
+		{ }
+		memoized(const memoized&) = default;
+		memoized& operator=(const memoized&) = default;
+		~memoized()
+		{ }
+
+		const V& base() const
+		{
+			return v;
+		}
+		uint64_t hits() const
+		{
+			return c->hits();
+		}
+		uint64_t misses() const
+		{
+			return c->misses();
+		}
+		size_t capacity() const
+		{
+			return c->table.size();
+		}
+
+		X cdf(X x, S s = 0, unsigned n = 0) const
+		{
+			return memo<X>(CDF, n, bits(x), bits(s), [&]() { return v.cdf(x, s, n); });
+		}
+		// cached values and one batch call for the rest, x and out may alias
+		void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+		{
+			ensure(out.size() >= x.size());
+
+			uint64_t k0 = (uint64_t(CDF) << 32) | n, u;
+			std::vector<size_t> i_; // indices of misses
+			std::vector<X> x_, y_;
+			for (size_t i = 0; i < x.size(); ++i) {
+				X xi = x[i];
+				if (c->find(k0, bits(xi), bits(s), u)) {
+					out[i] = std::bit_cast<X>(u);
+				}
+				else {
+					i_.push_back(i);
+					x_.push_back(xi);
+				}
+			}
+			if (x_.size()) {
+				y_.resize(x_.size());
+				variate::cdf(v, std::span<const X>(x_), s, n, std::span<X>(y_));
+				for (size_t j = 0; j < i_.size(); ++j) {
+					c->store(k0, bits(x_[j]), bits(s), bits(y_[j]));
+					out[i_[j]] = y_[j];
+				}
+			}
+		}
+		void cdf_jet(X x, S s, unsigned N, std::span<X> out) const
+		{
+			variate::cdf_jet(v, x, s, N, out);
+		}
+
+		S cumulant(S s, unsigned n = 0) const
+		{
+			return memo<S>(CUMULANT, n, 0, bits(s), [&]() { return v.cumulant(s, n); });
+		}
+		std::complex<S> cumulant(std::complex<S> z) const
+			requires variate_cumulant_complex_concept<V>
+		{
+			return v.cumulant(z);
+		}
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			variate::cumulant_jet(v, s, N, out);
+		}
+
+		X edf(S s, X x) const
+		{
+			return memo<X>(EDF, 0, bits(x), bits(s), [&]() { return v.edf(s, x); });
+		}
+
+		X quantile(X p, S s = 0) const
+		{
+			return memo<X>(QUANTILE, 0, bits(p), bits(s), [&]() { return variate::quantile(v, p, s); });
+		}
+
+		template<std::uniform_random_bit_generator G>
+		void sample(G& g, std::span<X> out, S s = 0) const
+		{
+			variate::sample(v, g, out, s);
+		}
+	};
+
+}
@@ -0,0 +1,133 @@
+// fms_variate_memoized.t.cpp - test cached variate
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "fms_test.h"
+#include "fms_parallel.h"
+#include "fms_random.h"
+#include "fms_variate_handle.h"
+#include "fms_variate_logistic.h"
+#include "fms_variate_memoized.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<memoized<logistic<>>>);
+static_assert(variate_batch_concept<memoized<logistic<>>>);
+static_assert(variate_quantile_concept<memoized<standard_normal<>>>);
+
+template<class X>
+int test_variate_memoized()
+{
+	{
+		logistic<X> v(2, 3);
+		memoized m(v, 100);
+		assert(m.capacity() == 128);
+		assert(m.hits() == 0 and m.misses() == 0);
+
+		assert(m.cdf(X(0.5), X(0.25)) == v.cdf(X(0.5), X(0.25)));
+		assert(m.hits() == 0 and m.misses() == 1);
+		assert(m.cdf(X(0.5), X(0.25)) == v.cdf(X(0.5), X(0.25)));
+		assert(m.hits() == 1 and m.misses() == 1);
+		// every argument is part of the key
+		assert(m.cdf(X(0.5), X(0.25), 1) == v.cdf(X(0.5), X(0.25), 1));
+		assert(m.cdf(X(0.5)) == v.cdf(X(0.5)));
+		assert(m.edf(X(0.25), X(0.5)) == v.edf(X(0.25), X(0.5)));
+		assert(m.cumulant(X(0.25)) == v.cumulant(X(0.25)));
+		assert(m.cumulant(X(0.25), 2) == v.cumulant(X(0.25), 2));
+		assert(m.quantile(X(0.25)) == v.quantile(X(0.25)));
+		assert(m.hits() == 1 and m.misses() == 7);
+
+		// copies share the cache
+		auto m2 = m;
+		assert(m2.cumulant(X(0.25), 2) == v.cumulant(X(0.25), 2));
+		assert(m.hits() == 2);
+
+		// batch mixes hits and misses, in place
+		std::vector<X> x = { X(0.5), X(-1), X(0.5), X(2) }, y(x);
+		m.cdf(y, X(0.25), 0, y);
+		for (size_t i = 0; i < x.size(); ++i) {
+			assert(fabs(y[i] - v.cdf(x[i], X(0.25))) < 1e-15);
+		}
+		assert(m.hits() == 4 and m.misses() == 9);
+	}
+	{
+		// many threads, few slots
+		logistic<X> v(2, 3);
+		memoized m(v, 16);
+		std::vector<X> x(200);
+		for (size_t i = 0; i < x.size(); ++i) {
+			x[i] = X(-5 + 10 * X(i) / x.size());
+		}
+		size_t n = 1000;
+		parallel::for_each(n, [&](size_t k) {
+			X s = X(0.1) * (k % 3);
+			for (X xi : x) {
+				ensure(m.cdf(xi, s) == v.cdf(xi, s));
+				ensure(m.edf(s, xi) == v.edf(s, xi));
+			}
+			ensure(m.cumulant(s, 2) == v.cumulant(s, 2));
+		}, 4);
+		assert(m.hits() + m.misses() == n * (2 * x.size() + 1));
+	}
+	{
+		// drops into the handle
+		std::unique_ptr<variate_base<X>> h(new variate_handle(memoized(standard_normal<X>{})));
+		assert(h->cdf(X(1), X(0.5)) == standard_normal<X>::cdf(X(1), X(0.5)));
+		assert(h->cdf(X(1), X(0.5)) == standard_normal<X>::cdf(X(1), X(0.5)));
+	}
+
+	return 0;
+}
+int test_variate_memoized_d = test_variate_memoized<double>();
+
+// Replay the calls of a spreadsheet that recalculates the same cells and
+// a trace with no repeats to measure the cost of a miss.
+int benchmark_variate_memoized()
+{
+	random::philox g(5);
+	logistic<> v(2, 3);
+	struct call {
+		double x, s;
+		unsigned n;
+	};
+
+	// 400 cells recalculated 50 times
+	std::vector<call> cells, trace;
+	for (int i = 0; i < 400; ++i) {
+		cells.push_back({ random::normal(g), 0.1 * (i % 5), unsigned(i % 2) });
+	}
+	for (int k = 0; k < 50; ++k) {
+		trace.insert(trace.end(), cells.begin(), cells.end());
+	}
+	auto replay = [&trace](const auto& v) {
+		double sum = 0;
+		for (const auto& c : trace) {
+			sum += v.cdf(c.x, c.s, c.n) + v.cumulant(c.s, 2);
+		}
+		return sum;
+	};
+
+	double sum_model = 0, sum_memo = 0;
+	memoized m(v);
+	double ms_model = test::report("memoized model trace ms", test::best(3, [&]() { sum_model = replay(v); }));
+	double ms_memo = test::report("memoized hit trace ms", test::best(3, [&]() { sum_memo = replay(m); }));
+	assert(sum_memo == sum_model);
+	assert(m.hits() > 10 * m.misses()); // direct mapped slots collide
+	assert(ms_memo < 10 * ms_model); // not horrible
+
+	// all misses
+	for (auto& c : trace) {
+		c.x = random::normal(g);
+	}
+	memoized m2(v, 1 << 10);
+	ms_model = test::report("memoized model miss trace ms", test::best(3, [&]() { sum_model = replay(v); }));
+	ms_memo = test::report("memoized miss trace ms", test::best(3, [&]() { sum_memo = replay(m2); }));
+	assert(sum_memo == sum_model);
+	assert(ms_memo < 10 * ms_model); // not horrible
+
+	return 0;
+}
+int benchmark_variate_memoized_ = benchmark_variate_memoized();
@@ -1,6 +1,13 @@
 // fms_variate_normal.h - normal distribution
 #pragma once
 #include <cmath>
+#include <complex>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include "fms_ensure.h"
+#include "fms_random.h"
+#include "fms_sf_simd.h"
 
 namespace fms::variate {
 
@@ -8,16 +15,45 @@ namespace fms::variate {
 	template<class X>
 	inline constexpr X Hermite(unsigned n, X x)
 	{
-		if (n == 0) {
-			return X(1);
-		}
-		if (n == 1) {
-			return x;
+		X H_ = 0, H = 1; // H_{k-1}, H_k
+
+		for (unsigned k = 0; k < n; ++k) {
+			X H1 = x * H - X(k) * H_;
+			H_ = H;
+			H = H1;
 		}
 
-		return x * Hermite(n - 1, x) - X(n - 1) * Hermite(n - 2, x);
+		return H;
 	}
 
+	// H_0(x_i), ..., H_N(x_i) for all x_i stored by order: H[n * x.size() + i] = H_n(x_i)
+	template<class X>
+	inline void Hermite(unsigned N, std::span<const X> x, std::span<X> H)
+	{
+		const size_t m = x.size();
+		ensure(H.size() >= (N + 1) * m);
+
+		X* H0 = H.data();
+		for (size_t i = 0; i < m; ++i) {
+			H0[i] = 1;
+		}
+		if (N == 0) {
+			return;
+		}
+
+		X* H1 = H0 + m;
+		for (size_t i = 0; i < m; ++i) {
+			H1[i] = x[i];
+		}
+		for (unsigned n = 1; n < N; ++n) {
+			const X* H_ = H0 + (n - 1) * m;
+			const X* Hn = H_ + m;
+			X* Hn1 = H0 + (n + 1) * m;
+			for (size_t i = 0; i < m; ++i) {
+				Hn1[i] = x[i] * Hn[i] - X(n) * H_[i];
+			}
+		}
+	}
 
 	// Normal mean 0 variance 1
 	template<class X = double, class S = X>
@@ -39,7 +75,8 @@ namespace fms::variate {
 			X x_ = x - s;
 
 			if (n == 0) {
-				return (1 + erf(x_ / X(M_SQRT2))) / 2;
+				// (1 + erf(x/sqrt(2)))/2 loses all precision in the lower tail
+				return erfc(-x_ / X(M_SQRT2)) / 2;
 			}
 
 			X phi = exp(-x_ * x_ / X(2)) / X(M_SQRT2PI);
@@ -52,6 +89,131 @@ namespace fms::variate {
 			return phi * Hermite(n - 1, x_) * ((n&1) ? 1 : -1);
 		}
 
+		// out[i] = cdf(x[i], s, n) using SIMD kernels for double, x and out may alias.
+		// For n = 0 the result is within 4e-16 of the scalar path and has relative error 
+		// below 3 ulp in the lower tail where (1 + erf(x/sqrt(2)))/2 loses all precision.
+		// For n > 0 the relative error is below 4 ulp times the condition number of H_{n-1}.
+		static void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out)
+		{
+			ensure(out.size() >= x.size());
+
+			if constexpr (std::is_same_v<X, double> and std::is_same_v<S, double>) {
+				// single lanes are slower than the runtime library erfc and exp
+				if (simd::best() == simd::level::scalar) {
+					for (size_t i = 0; i < x.size(); ++i) {
+						out[i] = n == 0 ? erfc((s - x[i]) * X(0.70710678118654752440)) / 2 : cdf(x[i], s, n);
+					}
+				}
+				else {
+					if (n == 0) {
+						// Phi(x) = erfc(-x/sqrt(2))/2
+						simd::transform(x, out, [s](auto x) {
+							using V = decltype(x);
+							return V(0.5) * sf::lane::erfc((V(s) - x) * V(0.70710678118654752440));
+						});
+					}
+					else {
+						simd::transform(x, out, [s, n](auto x) {
+							using V = decltype(x);
+							V x_ = x - V(s);
+							V phi = sf::lane::exp(V(-0.5) * x_ * x_) * V(1 / M_SQRT2PI);
+							V H_(0), H(1); // H_{k-1}, H_k
+							for (unsigned k = 0; k + 1 < n; ++k) {
+								V H1 = x_ * H - V(double(k)) * H_;
+								H_ = H;
+								H = H1;
+							}
+
+							return (n & 1) ? phi * H : -(phi * H);
+						});
+					}
+				}
+			}
+			else {
+				for (size_t i = 0; i < x.size(); ++i) {
+					out[i] = cdf(x[i], s, n);
+				}
+			}
+		}
+
+		// cdf(x, s, 0), ..., cdf(x, s, N) sharing phi and the Hermite recurrence
+		static void cdf_jet(X x, S s, unsigned N, std::span<X> out)
+		{
+			X x_ = x - s;
+
+			out[0] = erfc(-x_ / X(M_SQRT2)) / 2;
+			if (N == 0) {
+				return;
+			}
+
+			X phi = exp(-x_ * x_ / X(2)) / X(M_SQRT2PI);
+			X H_ = 0, H = 1; // H_{n-2}, H_{n-1}
+			for (unsigned n = 1; n <= N; ++n) {
+				out[n] = phi * H * ((n & 1) ? 1 : -1);
+				X H1 = x_ * H - X(n - 1) * H_;
+				H_ = H;
+				H = H1;
+			}
+		}
+
+		// s + Phi^{-1}(p) using Acklam's rational approximation, relative error 1.15e-9,
+		// and one Halley step. Upper half uses Phi^{-1}(p) = -Phi^{-1}(1 - p).
+		static X quantile(X p, S s = 0)
+		{
+			static constexpr X a[] = { X(-3.969683028665376e+01), X(2.209460984245205e+02), X(-2.759285104469687e+02),
+				X(1.383577518672690e+02), X(-3.066479806614716e+01), X(2.506628277459239e+00) };
+			static constexpr X b[] = { X(-5.447609879822406e+01), X(1.615858368580409e+02), X(-1.556989798598866e+02),
+				X(6.680131188771972e+01), X(-1.328068155288572e+01) };
+			static constexpr X c[] = { X(-7.784894002430293e-03), X(-3.223964580411365e-01), X(-2.400758277161838e+00),
+				X(-2.549732539343734e+00), X(4.374664141464968e+00), X(2.938163982698783e+00) };
+			static constexpr X d[] = { X(7.784695709041462e-03), X(3.224671290700398e-01), X(2.445134137142996e+00),
+				X(3.754408661907416e+00) };
+
+			ensure(0 <= p and p <= 1);
+
+			if (p > X(0.5)) {
+				return s - quantile(1 - p);
+			}
+			if (p == 0) {
+				return -std::numeric_limits<X>::infinity();
+			}
+
+			X x;
+			if (p < X(0.02425)) {
+				X q = sqrt(-2 * log(p));
+				x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+					/ ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+			}
+			else {
+				X q = p - X(0.5);
+				X r = q * q;
+				x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q
+					/ (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+			}
+
+			// Phi(x) = erfc(-x/sqrt(2))/2 is accurate for x < 0
+			X e = erfc(-x / X(M_SQRT2)) / 2 - p;
+			X ex = exp(x * x / 2);
+			// skip the Halley step when it would be 0 times inf, e.g. p = denorm_min
+			if (e != 0 and std::isfinite(ex)) {
+				X u = e * X(M_SQRT2PI) * ex;
+				x = x - u / (1 + x * u / 2);
+			}
+
+			return s + x;
+		}
+
+		// X_s is normal with mean s
+		template<std::uniform_random_bit_generator G>
+		static void sample(G& g, std::span<X> out, S s = 0)
+		{
+			const auto& z = random::ziggurat::table();
+
+			for (auto& x : out) {
+				x = s + X(z(g));
+			}
+		}
+
 		// (d/ds) cdf(x, s, 0)
 		static X edf(S s, X x)
 		{
@@ -72,6 +234,11 @@ namespace fms::variate {
 
 			return S(0);
 		}
+		// kappa(z) = z^2/2
+		static std::complex<S> cumulant(std::complex<S> z)
+		{
+			return z * z / S(2);
+		}
 		
 		/*
 		template<unsigned N>
@@ -1,9 +1,13 @@
 // fms_option.t.cpp - test fms option
 
 #include <cassert>
+#include <algorithm>
+#include <random>
+#include <string>
 #include <vector>
 #include "fms_test.h"
 #include "fms_variate.h"
+#include "fms_variate_sample.h"
 #include "fms_variate_normal.h"
 
 using namespace fms::test;
@@ -24,6 +28,82 @@ int test_hermite()
 }
 int test_hermite_d = test_hermite<double>();
 
+// H_{n+1}(x) = x H_n(x) - n H_{n-1}(x) using recursion
+template<class X>
+inline X Hermite_recursive(unsigned n, X x)
+{
+	if (n == 0) {
+		return X(1);
+	}
+	if (n == 1) {
+		return x;
+	}
+
+	return x * Hermite_recursive(n - 1, x) - X(n - 1) * Hermite_recursive(n - 2, x);
+}
+
+template<class X>
+int test_hermite_batch()
+{
+	constexpr unsigned N = 20;
+	auto x = range<X>(-3, 3, X(0.25));
+	const size_t m = x.size();
+	std::vector<X> H((N + 1) * m);
+
+	Hermite<X>(N, std::span<const X>(&x[0], m), std::span<X>(H));
+	for (unsigned n = 0; n <= N; ++n) {
+		for (size_t i = 0; i < m; ++i) {
+			X Hn = Hermite_recursive(n, x[i]);
+			assert(Hermite(n, x[i]) == H[n * m + i]);
+			assert(fabs(H[n * m + i] - Hn) <= 1e-12 * std::max(X(1), fabs(Hn)));
+		}
+	}
+
+	return 0;
+}
+int test_hermite_batch_d = test_hermite_batch<double>();
+
+// milliseconds per x for the recursive, iterative, and batch Hermite polynomials
+template<class X>
+int benchmark_hermite()
+{
+	constexpr unsigned N = 20;
+	auto x = range<X>(-3, 3, X(0.01));
+	const size_t m = x.size();
+	std::vector<X> H((N + 1) * m);
+	double ms[N + 1] = { 0 }, ms_[N + 1] = { 0 }, ms_batch[N + 1] = { 0 };
+	X sum = 0;
+
+	for (unsigned n = 2; n <= N; ++n) {
+		ms_[n] = best(5, [&]() {
+			for (X xi : x) {
+				sum += Hermite_recursive(n, xi);
+			}
+		}) / m;
+		ms[n] = best(5, [&]() {
+			for (X xi : x) {
+				sum += Hermite(n, xi);
+			}
+		}) / m;
+		ms_batch[n] = best(5, [&]() {
+			Hermite<X>(n, std::span<const X>(&x[0], m), std::span<X>(H));
+		}) / m;
+		report("Hermite recursive ms n=" + std::to_string(n), ms_[n]);
+		report("Hermite iterative ms n=" + std::to_string(n), ms[n]);
+		report("Hermite batch ms n=" + std::to_string(n), ms_batch[n]);
+	}
+	assert(ms[N] < ms_[N]);
+	// the table holds every order up to N
+	double ms_all = 0;
+	for (unsigned n = 2; n <= N; ++n) {
+		ms_all += ms[n];
+	}
+	assert(ms_batch[N] < 4 * ms_all); // not horrible
+
+	return sum != 0;
+}
+int benchmark_hermite_d = benchmark_hermite<double>();
+
 template<class X>
 int test_variate_normal()
 {
@@ -45,6 +125,35 @@ int test_variate_normal()
 			}
 		}
 	}
+	{
+		standard_normal<X> N;
+		constexpr unsigned N_ = 6;
+		X jet[N_ + 1];
+
+		for (X s : {X(-0.1), X(0), X(0.2)}) {
+			for (X x : {X(-2), X(0), X(0.5), X(3)}) {
+				cdf_jet(N, x, s, N_, std::span<X>(jet));
+				for (unsigned n = 0; n <= N_; ++n) {
+					X cn = N.cdf(x, s, n);
+					assert(fabs(jet[n] - cn) <= 1e-14 * std::max(X(1), fabs(cn)));
+				}
+			}
+		}
+
+		X mu = 2, sigma = 3;
+		affine N2(N, mu, sigma);
+		for (X s : {X(-0.1), X(0), X(0.2)}) {
+			for (X x : {X(-2), X(0), X(0.5), X(3)}) {
+				cdf_jet(N2, x, s, N_, std::span<X>(jet));
+				for (unsigned n = 0; n <= N_; ++n) {
+					X cn = N2.cdf(x, s, n);
+					assert(fabs(jet[n] - cn) <= 1e-14 * std::max(X(1), fabs(cn)));
+				}
+				// mean mu + sigma^2 s and variance sigma^2
+				assert(fabs(N2.cdf(x, s) - N.cdf((x - mu - sigma * sigma * s) / sigma)) <= 1e-15);
+			}
+		}
+	}
 	{
 		standard_normal<X> n;
 
@@ -66,5 +175,162 @@ int test_variate_normal()
 	}
 	return 0;
 }
+
+template<class X>
+int test_variate_normal_batch()
+{
+	standard_normal<X> N;
+	auto x = range<X>(-37, 8, X(0.001));
+	const size_t m = x.size();
+	std::span<const X> x_(&x[0], m);
+	std::vector<X> y(m);
+
+	for (X s : {X(-0.5), X(0), X(1)}) {
+		cdf(N, x_, s, 0, y);
+		for (size_t i = 0; i < m; ++i) {
+			X y_ = N.cdf(x[i], s, 0);
+			assert(fabs(y[i] - y_) <= 4e-16);
+			// Phi(x) = erfc(-x/sqrt(2))/2
+			X z = erfc(-(x[i] - s) / sqrt(X(2))) / 2;
+			assert(z < std::numeric_limits<X>::min() or fabs(y[i] - z) <= 8 * std::numeric_limits<X>::epsilon() * z * std::max(X(1), (x[i] - s) * (x[i] - s)));
+		}
+		for (unsigned n = 1; n < 5; ++n) {
+			cdf(N, x_, s, n, y);
+			for (size_t i = 0; i < m; ++i) {
+				X y_ = N.cdf(x[i], s, n);
+				assert(fabs(y[i] - y_) <= 1e-14 * std::max(X(1), fabs(y_)));
+			}
+		}
+	}
+	{
+		X mu = 2, sigma = 3;
+		affine N2(N, mu, sigma);
+		for (unsigned n = 0; n < 3; ++n) {
+			cdf(N2, x_, X(0.1), n, y);
+			for (size_t i = 0; i < m; ++i) {
+				X y_ = N2.cdf(x[i], X(0.1), n);
+				assert(fabs(y[i] - y_) <= 1e-14 * std::max(X(1), fabs(y_)));
+			}
+		}
+		// in place
+		std::vector<X> z(&x[0], &x[0] + m);
+		cdf(N2, z, X(0.1), 0, z);
+		cdf(N2, x_, X(0.1), 0, y);
+		assert(z == y);
+	}
+
+	return 0;
+}
+int test_variate_normal_batch_d = test_variate_normal_batch<double>();
+
+// milliseconds per point for scalar and batch cdf
+template<class X>
+int benchmark_variate_normal_batch()
+{
+	standard_normal<X> N;
+	auto x = range<X>(-5, 5, X(0.0001));
+	const size_t m = x.size();
+	std::vector<X> y(m);
+	double ms[2], ms_batch[2];
+
+	for (unsigned n = 0; n < 2; ++n) {
+		ms[n] = time([&]() {
+			for (size_t i = 0; i < m; ++i) {
+				y[i] = N.cdf(x[i], 0, n);
+			}
+		}) / m;
+		ms_batch[n] = time([&]() {
+			cdf(N, std::span<const X>(&x[0], m), X(0), n, y);
+		}) / m;
+		assert(ms_batch[n] < 4 * ms[n]); // not horrible
+	}
+
+	return 0;
+}
+int benchmark_variate_normal_batch_d = benchmark_variate_normal_batch<double>();
+
+template<class X>
+int test_variate_normal_quantile()
+{
+	standard_normal<X> N;
+
+	for (X s : {X(-1), X(0), X(0.5)}) {
+		for (X p : {X(1e-300), X(1e-20), X(1e-5), X(0.02), X(0.3), X(0.5), X(0.7), X(0.98), X(1 - 1e-10)}) {
+			X x = quantile(N, p, s);
+			// relative error of p is at most the relative error of x times |x phi(x)/Phi(x)|
+			X q = erfc((p < X(0.5) ? s - x : x - s) * X(0.70710678118654752440)) / 2;
+			X p_ = p < X(0.5) ? p : 1 - p;
+			assert(fabs(q - p_) <= 4 * std::numeric_limits<X>::epsilon() * p_ * std::max(X(1), (x - s) * (x - s)));
+			// generic solver agrees with the closed form up to the absolute error of cdf
+			X y = quantile_solve(N, p, s, X(0), X(1));
+			assert(fabs(x - y) <= 4 * std::numeric_limits<X>::epsilon() * std::max(X(1), fabs(x)) / N.cdf(x, s, 1));
+		}
+		assert(quantile(N, X(0), s) == -std::numeric_limits<X>::infinity());
+		assert(quantile(N, X(1), s) == std::numeric_limits<X>::infinity());
+		assert(quantile(N, X(0.5), s) == s);
+		// exp(x^2/2) overflows in the Halley step
+		X q = quantile(N, std::numeric_limits<X>::denorm_min(), s);
+		assert(std::isfinite(q) and q - s < -38);
+	}
+	{
+		auto p = range<X>(X(0.001), X(0.999), X(0.001));
+		const size_t m = p.size();
+		std::vector<X> x(m), y(m);
+		quantile(N, std::span<const X>(&p[0], m), X(0.1), std::span<X>(x));
+		quantile_warm(N, std::span<const X>(&p[0], m), X(0.1), std::span<X>(y));
+		for (size_t i = 0; i < m; ++i) {
+			assert(fabs(x[i] - y[i]) <= 1e-12 * std::max(X(1), fabs(x[i])));
+		}
+	}
+
+	return 0;
+}
+int test_variate_normal_quantile_d = test_variate_normal_quantile<double>();
+
+template<class X>
+int test_variate_normal_sample()
+{
+	standard_normal<X> N;
+	std::mt19937_64 r(7);
+	std::vector<X> x(200'000);
+	X n = X(x.size());
+
+	for (X s : {X(0), X(-1), X(0.5)}) {
+		sample(N, r, std::span<X>(x), s);
+		std::sort(x.begin(), x.end());
+		X D = 0, m = 0;
+		for (size_t i = 0; i < x.size(); ++i) {
+			X F = erfc((s - x[i]) * X(0.70710678118654752440)) / 2;
+			D = std::max({ D, fabs(F - i / n), fabs((i + 1) / n - F) });
+			m += x[i];
+		}
+		assert(D < X(1.95) / sqrt(n));
+		assert(fabs(m / n - s) < 5 / sqrt(n));
+	}
+
+	return 0;
+}
+int test_variate_normal_sample_d = test_variate_normal_sample<double>();
+
+// samples per second for the ziggurat and inverting uniform draws with quantile
+template<class X>
+int benchmark_variate_normal_sample()
+{
+	standard_normal<X> N;
+	std::mt19937_64 r(0);
+	std::vector<X> x(1'000'000);
+
+	double per_sec = 1000 * x.size() / time([&]() { sample(N, r, std::span<X>(x)); });
+	double per_sec_inv = 1000 * x.size() / time([&]() {
+		for (auto& xi : x) {
+			xi = N.quantile(X(fms::random::uniform(r)));
+		}
+	});
+	assert(per_sec > per_sec_inv);
+
+	return 0;
+}
+int benchmark_variate_normal_sample_d = benchmark_variate_normal_sample<double>();
+
 //int test_variate_normal_f = test_variate_normal<float>();
 int test_variate_normal_d = test_variate_normal<double>();
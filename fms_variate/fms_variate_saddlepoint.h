@@ -0,0 +1,177 @@
+// fms_variate_saddlepoint.h - saddlepoint approximation of a variate from its cumulant
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_variate.h"
+
+namespace fms::variate {
+
+	static inline const char saddlepoint_doc[] = R"xyzyx(
+Approximate the cdf and density of \(X_s\) using only the cumulant of \(X\).
+The saddlepoint \(t\) solves \(\kappa'(t) = x\). With \(u = t - s\),
+\(w = \operatorname{sgn}(u)\sqrt{2(ux - \kappa(t) + \kappa(s))}\), and \(v = u\sqrt{\kappa''(t)}\)
+the Lugannani-Rice approximation is \(F_s(x) \approx \Phi(w) + \phi(w)(1/w - 1/v)\) and the density is
+\(f_s(x) \approx \exp(\kappa(t) - \kappa(s) - ux)/\sqrt{2\pi\kappa''(t)}\).
+The second order approximation of Daniels adds
+\(-\phi(w)(c/v - \lambda_3/(2v^2) - 1/v^3 + 1/w^3)\) to the cdf and multiplies the density by \(1 + c\) where
+\(c = \lambda_4/8 - 5\lambda_3^2/24\) and \(\lambda_n = \kappa^{(n)}(t)/\kappa''(t)^{n/2}\).
+Near the mean, where both \(w\) and \(v\) vanish, the cdf is interpolated.
+)xyzyx";
+	template<variate_concept V, class X = typename V::xtype, class S = typename V::stype>
+	class saddlepoint {
+		V v;
+		unsigned order; // 1 or 2
+
+		// cdf within band standard deviations of the mean is interpolated
+		static constexpr X band = X(0.05);
+
+		// F_s(x), f_s(x), f_s'(x) at the saddlepoint t where ks = kappa(s)
+		void jet(X x, S s, S t, S ks, std::span<X> F) const
+		{
+			static constexpr X sqrt2pi = X(2.50662827463100050242);
+			S K[5];
+			variate::cumulant_jet(v, t, 4, std::span<S>(K));
+			S u = t - s;
+			S sd = sqrt(K[2]);
+			S l3 = K[3] / (K[2] * sd);
+			S l4 = K[4] / (K[2] * K[2]);
+			X c = order == 2 ? X(l4 / 8 - 5 * l3 * l3 / 24) : X(0);
+
+			X e = std::max(X(u * x - (K[0] - ks)), X(0)); // w^2/2
+			X f = exp(-e) / (sqrt2pi * sd);
+			F[1] = f * (1 + c);
+			// d/dx (kappa(t) - ux) = -u and d/dx kappa''(t) = kappa'''(t)/kappa''(t)
+			F[2] = F[1] * X(-u - K[3] / (2 * K[2] * K[2]));
+
+			X w = copysign(sqrt(2 * e), X(u));
+			X v_ = X(u * sd);
+			X phi = exp(-e) / sqrt2pi;
+			X R = 1 / w - 1 / v_;
+			if (order == 2) {
+				R -= c / v_ - X(l3) / (2 * v_ * v_) - 1 / (v_ * v_ * v_) + 1 / (w * w * w);
+			}
+			F[0] = erfc(-w * X(0.70710678118654752440)) / 2 + phi * R;
+		}
+		// F_s(x) interpolated by a quintic at m + k h, k = +-1, +-2, +-3, where m is the mean of X_s
+		X interpolate(X x, S s, S ks, X m, X h) const
+		{
+			static constexpr X k[] = { X(-3), X(-2), X(-1), X(1), X(2), X(3) };
+			X r = (x - m) / h;
+			X F[3], y = 0;
+			S t = s;
+			for (int i = 0; i < 6; ++i) {
+				X x_ = m + k[i] * h;
+				t = cumulant_solve(v, x_, t);
+				jet(x_, s, t, ks, std::span<X>(F));
+				X L = 1;
+				for (int j = 0; j < 6; ++j) {
+					if (j != i) {
+						L *= (r - k[j]) / (k[i] - k[j]);
+					}
+				}
+				y += L * F[0];
+			}
+
+			return y;
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		saddlepoint(const V& v = V{}, unsigned order = 2)
+			: v(v), order(order)
+		{
+			ensure(order == 1 or order == 2);
+		}
+
+		// F_s(x), f_s(x), and f_s'(x) for N <= 2 solving for the saddlepoint starting at t
+		// The derivative of the density omits the change in the second order factor.
+		void cdf_jet(X x, S s, unsigned N, std::span<X> out, S t) const
+		{
+			ensure(N <= 2);
+			ensure(out.size() > N);
+
+			S K[3];
+			variate::cumulant_jet(v, s, 2, std::span<S>(K));
+			X F[3];
+			t = cumulant_solve(v, x, t);
+			jet(x, s, t, K[0], std::span<X>(F));
+			X h = X(band * sqrt(K[2]));
+			if (fabs(x - K[1]) < h) {
+				F[0] = interpolate(x, s, K[0], X(K[1]), h);
+			}
+			std::copy(F, F + N + 1, out.begin());
+		}
+		void cdf_jet(X x, S s, unsigned N, std::span<X> out) const
+		{
+			cdf_jet(x, s, N, out, s);
+		}
+
+		X cdf(X x, S s = 0, unsigned n = 0) const
+		{
+			X F[3];
+			cdf_jet(x, s, n, std::span<X>(F));
+
+			return F[n];
+		}
+
+		// out[i] = cdf(x[i], s, n) solving for the saddlepoints in increasing order of x
+		// starting each from the previous one, x and out may alias
+		void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+		{
+			ensure(n <= 2);
+			ensure(out.size() >= x.size());
+
+			std::vector<size_t> k(x.size());
+			std::iota(k.begin(), k.end(), size_t(0));
+			if (!std::is_sorted(x.begin(), x.end())) {
+				std::sort(k.begin(), k.end(), [x](size_t i, size_t j) { return x[i] < x[j]; });
+			}
+
+			S K[3];
+			variate::cumulant_jet(v, s, 2, std::span<S>(K));
+			X h = X(band * sqrt(K[2]));
+			S t = s;
+			X F[3];
+			for (size_t i : k) {
+				X xi = x[i];
+				t = cumulant_solve(v, xi, t);
+				jet(xi, s, t, K[0], std::span<X>(F));
+				if (n == 0 and fabs(xi - K[1]) < h) {
+					F[0] = interpolate(xi, s, K[0], X(K[1]), h);
+				}
+				out[i] = F[n];
+			}
+		}
+
+		S cumulant(S s, unsigned n = 0) const
+		{
+			return v.cumulant(s, n);
+		}
+		std::complex<S> cumulant(std::complex<S> z) const
+			requires variate_cumulant_complex_concept<V>
+		{
+			return v.cumulant(z);
+		}
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			variate::cumulant_jet(v, s, N, out);
+		}
+
+		// central difference of the approximate cdf in s
+		X edf(S s, X x) const
+		{
+			static const S h = std::cbrt(std::numeric_limits<S>::epsilon());
+			S ds = h * std::max(S(1), fabs(s));
+
+			return (cdf(x, s + ds) - cdf(x, s - ds)) / X(2 * ds);
+		}
+	};
+
+}
@@ -0,0 +1,53 @@
+// fms_variate_sample.h - draws from Esscher transformed variates
+#pragma once
+#include <random>
+#include <span>
+#include <type_traits>
+#include "fms_ensure.h"
+#include "fms_random.h"
+#include "fms_random_sobol.h"
+#include "fms_variate.h"
+
+namespace fms::variate {
+
+	static inline const char sample_doc[] = R"xyzyx(
+Fill an array with independent draws from the Esscher transformed variate \(X_s\).
+Variates implement <code>sample</code> with a method suited to the model, 
+otherwise uniform draws are inverted using <code>quantile</code>.
+)xyzyx";
+	template<variate_concept V, std::uniform_random_bit_generator G>
+	inline void sample(const V& v, G& g, std::span<typename V::xtype> out, typename V::stype s)
+	{
+		using X = typename V::xtype;
+
+		if constexpr (variate_sample_concept<V, G>) {
+			v.sample(g, out, s);
+		}
+		else {
+			for (auto& x : out) {
+				x = X(random::uniform(g));
+			}
+			quantile(v, std::span<const X>(out.data(), out.size()), s, out);
+		}
+	}
+	// next out.size() points of a one dimensional Sobol sequence mapped through quantile
+	template<variate_concept V>
+	inline void sample(const V& v, random::sobol& q, std::span<typename V::xtype> out, typename V::stype s = 0)
+	{
+		using X = typename V::xtype;
+		ensure(q.dimension() == 1);
+
+		if constexpr (std::is_same_v<X, double>) {
+			q(out.size(), out);
+		}
+		else {
+			for (auto& x : out) {
+				double u;
+				q(std::span<double>(&u, 1));
+				x = X(u);
+			}
+		}
+		quantile(v, std::span<const X>(out.data(), out.size()), s, out);
+	}
+
+}
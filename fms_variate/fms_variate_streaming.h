@@ -0,0 +1,198 @@
+// fms_variate_streaming.h - online, mergeable cumulant estimates
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_variate_normal.h"
+
+namespace fms::variate {
+
+	static inline const char streaming_doc[] = R"xyzyx(
+Estimate cumulants of a stream of observations without storing them.
+The count, mean, and central sums \(M_k = \sum_i (x_i - \bar{x})^k\), \(k = 2,3,4\), are updated
+one observation at a time and partial results are merged using the formulas of Pébay (2008).
+The unbiased k-statistics are \(k_1 = \bar{x}\), \(k_2 = M_2/(n - 1)\), \(k_3 = nM_3/((n - 1)(n - 2))\), and
+\(k_4 = (n(n + 1)M_4 - 3(n - 1)M_2^2)/((n - 1)(n - 2)(n - 3))\).
+The empirical cumulant \(\log(\sum_i e^{s_j x_i}/n)\) is also kept on a fixed grid of \(s_j\) as a sum
+scaled by the largest \(s_jx_i\) seen so far.
+As a variate the cumulant is \(\kappa(s) = k_1s + k_2s^2/2 + k_3s^3/6 + k_4s^4/24\) and the cdf of \(X_s\) is
+the Edgeworth expansion \(\Phi(z) - \phi(z)(\gamma_1 H_2(z)/6 + \gamma_2 H_3(z)/24 + \gamma_1^2 H_5(z)/72)\)
+where \(z = (x - \kappa'(s))/\sqrt{\kappa''(s)}\), \(\gamma_1 = \kappa'''(s)/\kappa''(s)^{3/2}\), and \(\gamma_2 = \kappa''''(s)/\kappa''(s)^2\).
+)xyzyx";
+	template<class X = double, class S = X>
+	class streaming {
+		size_t n;
+		X mean, M2, M3, M4;
+		std::vector<S> s_; // grid
+		std::vector<S> m_; // largest s_j x_i
+		std::vector<S> w_; // sum of exp(s_j x_i - m_j)
+
+		// k_j if defined by the count, otherwise 0
+		X k_(unsigned j) const
+		{
+			return n >= j ? k(j) : X(0);
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// empirical cumulant on grid
+		streaming(std::span<const S> grid = {})
+			: n(0), mean(0), M2(0), M3(0), M4(0), s_(grid.begin(), grid.end()),
+			m_(grid.size(), -std::numeric_limits<S>::infinity()), w_(grid.size(), S(0))
+		{ }
+
+		size_t count() const
+		{
+			return n;
+		}
+		std::span<const S> grid() const
+		{
+			return s_;
+		}
+
+		// O(1) update for the moments and O(grid) for the empirical cumulant
+		streaming& add(X x)
+		{
+			X n1 = X(n);
+			++n;
+			X n_ = X(n);
+			X d = x - mean;
+			X dn = d / n_;
+			X dn2 = dn * dn;
+			X t = d * dn * n1;
+			mean += dn;
+			M4 += t * dn2 * (n_ * n_ - 3 * n_ + 3) + 6 * dn2 * M2 - 4 * dn * M3;
+			M3 += t * dn * (n_ - 2) - 3 * dn * M2;
+			M2 += t;
+
+			for (size_t j = 0; j < s_.size(); ++j) {
+				S sx = s_[j] * x;
+				if (sx > m_[j]) {
+					w_[j] = w_[j] * exp(m_[j] - sx) + 1;
+					m_[j] = sx;
+				}
+				else {
+					w_[j] += exp(sx - m_[j]);
+				}
+			}
+
+			return *this;
+		}
+		streaming& add(std::span<const X> x)
+		{
+			for (X xi : x) {
+				add(xi);
+			}
+
+			return *this;
+		}
+
+		// combine with statistics of a disjoint sample using the same grid
+		streaming& operator+=(const streaming& b)
+		{
+			ensure(s_ == b.s_);
+
+			if (b.n == 0) {
+				return *this;
+			}
+			if (n == 0) {
+				return *this = b;
+			}
+
+			X na = X(n), nb = X(b.n), n_ = na + nb;
+			X d = b.mean - mean;
+			X d2 = d * d;
+			M4 += b.M4 + d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (n_ * n_ * n_)
+				+ 6 * d2 * (na * na * b.M2 + nb * nb * M2) / (n_ * n_) + 4 * d * (na * b.M3 - nb * M3) / n_;
+			M3 += b.M3 + d2 * d * na * nb * (na - nb) / (n_ * n_) + 3 * d * (na * b.M2 - nb * M2) / n_;
+			M2 += b.M2 + d2 * na * nb / n_;
+			mean += d * nb / n_;
+			n += b.n;
+
+			for (size_t j = 0; j < s_.size(); ++j) {
+				S m = std::max(m_[j], b.m_[j]);
+				w_[j] = w_[j] * exp(m_[j] - m) + b.w_[j] * exp(b.m_[j] - m);
+				m_[j] = m;
+			}
+
+			return *this;
+		}
+
+		// unbiased estimate of the cumulant kappa_j for 1 <= j <= 4
+		X k(unsigned j) const
+		{
+			ensure(1 <= j and j <= 4);
+			ensure(n >= j);
+
+			X n_ = X(n);
+			switch (j) {
+			case 1:
+				return mean;
+			case 2:
+				return M2 / (n_ - 1);
+			case 3:
+				return n_ * M3 / ((n_ - 1) * (n_ - 2));
+			default:
+				return (n_ * (n_ + 1) * M4 - 3 * (n_ - 1) * M2 * M2) / ((n_ - 1) * (n_ - 2) * (n_ - 3));
+			}
+		}
+		// log(sum_i exp(s_j x_i)/n) for grid point j
+		S empirical_cumulant(size_t j) const
+		{
+			ensure(n > 0);
+
+			return m_[j] + log(w_[j] / S(n));
+		}
+
+		// n-th derivative of k_1 s + k_2 s^2/2 + k_3 s^3/6 + k_4 s^4/24
+		S cumulant(S s, unsigned n_ = 0) const
+		{
+			S K = 0;
+			for (unsigned j = 4; j >= std::max(n_, 1u); --j) {
+				S t = S(k_(j));
+				for (unsigned i = 1; i <= j - n_; ++i) {
+					t *= s / S(i);
+				}
+				K += t;
+			}
+
+			return K;
+		}
+
+		// n-th derivative of the Edgeworth expansion of F_s
+		X cdf(X x, S s = 0, unsigned n_ = 0) const
+		{
+			S k2 = cumulant(s, 2);
+			ensure(k2 > 0);
+			X sigma = X(sqrt(k2));
+			X g1 = X(cumulant(s, 3) / (k2 * sigma));
+			X g2 = X(cumulant(s, 4) / (k2 * k2));
+			X z = (x - X(cumulant(s, 1))) / sigma;
+			X phi = exp(-z * z / 2) * X(0.39894228040143267794);
+
+			if (n_ == 0) {
+				return erfc(-z * X(0.70710678118654752440)) / 2
+					- phi * (g1 * Hermite(2, z) / 6 + g2 * Hermite(3, z) / 24 + g1 * g1 * Hermite(5, z) / 72);
+			}
+
+			X F = phi * (Hermite(n_ - 1, z) + g1 * Hermite(n_ + 2, z) / 6 + g2 * Hermite(n_ + 3, z) / 24
+				+ g1 * g1 * Hermite(n_ + 5, z) / 72) / pow(sigma, X(n_));
+
+			return n_ & 1 ? F : -F;
+		}
+
+		// central difference of the expansion in s
+		X edf(S s, X x) const
+		{
+			static const S h = std::cbrt(std::numeric_limits<S>::epsilon());
+			S ds = h * std::max(S(1), fabs(s));
+
+			return (cdf(x, s + ds) - cdf(x, s - ds)) / X(2 * ds);
+		}
+	};
+
+}
@@ -0,0 +1,130 @@
+// fms_variate_streaming.t.cpp - test online cumulant estimates
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+#include "fms_variate.h"
+#include "fms_variate_saddlepoint.h"
+#include "fms_variate_streaming.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<streaming<>>);
+
+template<class X>
+int test_variate_streaming()
+{
+	random::philox g(5);
+	{
+		// k-statistics from two passes over skewed data far from 0
+		size_t n = 1000;
+		std::vector<X> x(n);
+		for (auto& xi : x) {
+			xi = X(1000 + exp(random::normal(g)));
+		}
+		X m = 0;
+		for (X xi : x) {
+			m += xi / X(n);
+		}
+		X m2 = 0, m3 = 0, m4 = 0;
+		for (X xi : x) {
+			X d = xi - m;
+			m2 += d * d;
+			m3 += d * d * d;
+			m4 += d * d * d * d;
+		}
+		X n_ = X(n);
+		X k2 = m2 / (n_ - 1);
+		X k3 = n_ * m3 / ((n_ - 1) * (n_ - 2));
+		X k4 = (n_ * (n_ + 1) * m4 - 3 * (n_ - 1) * m2 * m2) / ((n_ - 1) * (n_ - 2) * (n_ - 3));
+
+		X s[] = { X(-0.1), X(0.01), X(0.1) };
+		streaming<X> S(s);
+		S.add(x);
+		assert(S.count() == n);
+		assert(fabs(S.k(1) - m) < 1e-12 * m);
+		assert(fabs(S.k(2) - k2) < 1e-11 * k2);
+		assert(fabs(S.k(3) - k3) < 1e-10 * fabs(k3));
+		assert(fabs(S.k(4) - k4) < 1e-10 * fabs(k4));
+
+		// merged partitions agree with one stream
+		streaming<X> P[4] = { S.grid(), S.grid(), S.grid(), S.grid() };
+		for (size_t i = 0; i < n; ++i) {
+			P[(i * 7) % 4].add(x[i]);
+		}
+		P[0] += P[1];
+		P[2] += P[3];
+		P[0] += P[2];
+		assert(P[0].count() == n);
+		for (unsigned j = 1; j <= 4; ++j) {
+			assert(fabs(P[0].k(j) - S.k(j)) < 1e-10 * fabs(S.k(j)));
+		}
+
+		// empirical cumulant on the grid
+		for (size_t j = 0; j < 3; ++j) {
+			X K = 0;
+			for (X xi : x) {
+				K += exp(s[j] * (xi - 1000)) / X(n);
+			}
+			K = log(K) + s[j] * 1000;
+			assert(fabs(S.empirical_cumulant(j) - K) < 1e-12 * fabs(K));
+			assert(fabs(P[0].empirical_cumulant(j) - K) < 1e-12 * fabs(K));
+		}
+	}
+	{
+		// normal data has k_3 and k_4 near 0 and the expansion is near the normal cdf
+		streaming<X> S;
+		size_t n = 1'000'000;
+		for (size_t i = 0; i < n; ++i) {
+			S.add(X(1 + 2 * random::normal(g)));
+		}
+		X se = X(1) / std::sqrt(X(n));
+		assert(fabs(S.k(1) - 1) < 5 * 2 * se);
+		assert(fabs(S.k(2) - 4) < 5 * 4 * std::sqrt(X(2)) * se);
+		assert(fabs(S.k(3)) < 5 * 8 * std::sqrt(X(6)) * se);
+		assert(fabs(S.k(4)) < 5 * 16 * std::sqrt(X(24)) * se);
+
+		X s = X(0.1);
+		assert(fabs(S.cumulant(s, 0) - (S.k(1) * s + S.k(2) * s * s / 2 + S.k(3) * s * s * s / 6 + S.k(4) * s * s * s * s / 24)) < 1e-15);
+		assert(S.cumulant(s, 4) == S.k(4));
+		assert(S.cumulant(s, 5) == 0);
+		for (X x : { X(-3), X(0), X(1.2), X(4) }) {
+			X z = (x - S.cumulant(s, 1)) / std::sqrt(S.cumulant(s, 2));
+			assert(fabs(S.cdf(x, s) - erfc(-z * X(0.70710678118654752440)) / 2) < 1e-3);
+			test::check(S.cdf(x, s, 1), [&](X y) { return S.cdf(y, s); }, x, X(1e-3));
+			test::check(S.cdf(x, s, 3), [&](X y) { return S.cdf(y, s, 2); }, x, X(1e-3));
+		}
+
+		// the rest of the library works on the estimate
+		X m = mean(S), v = variance(S);
+		affine Z(S, -m / std::sqrt(v), 1 / std::sqrt(v));
+		assert(fabs(mean(Z)) < 1e-12);
+		assert(fabs(variance(Z) - 1) < 1e-12);
+		saddlepoint<streaming<X>> SP(S);
+		X q = quantile(S, X(0.9), s);
+		assert(fabs(SP.cdf(q, s) - X(0.9)) < 1e-3);
+	}
+
+	return 0;
+}
+int test_variate_streaming_d = test_variate_streaming<double>();
+
+// updates per second
+int benchmark_variate_streaming()
+{
+	random::philox g(1);
+	std::vector<double> x(1 << 22);
+	for (auto& xi : x) {
+		xi = random::normal(g);
+	}
+
+	streaming<> S;
+	double ms = test::time([&]() { S.add(x); });
+	double per_sec = 1000 * x.size() / ms;
+	assert(per_sec > 1e6); // not horrible
+
+	return S.count() == x.size();
+}
+int benchmark_variate_streaming_ = benchmark_variate_streaming();
@@ -0,0 +1,386 @@
+// fms_variate_sum.h - sum of independent variates
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_fft.h"
+#include "fms_variate.h"
+#include "fms_variate_sample.h"
+#include "fms_variate_cache.h"
+
+namespace fms::variate {
+
+	static inline const char sum_doc[] = R"xyzyx(
+The sum \(X = X_1 + \cdots + X_m\) of independent variates has cumulant \(\kappa(s) = \sum_j \kappa_j(s)\)
+and its Esscher transform is the sum of the Esscher transformed parts, \(X_s = \sum_j (X_j)_s\).
+The cdf of \(X_s\) is the convolution \(F_s(x) = \int F_1(x - r)\rho(r)\,dr\) of the cdf of the first part with
+the density \(\rho\) of the sum of the others. Densities are sampled on a common grid covering all but \(10^{-15}\)
+of each part and convolved by FFT. The trapezoidal rule is spectrally accurate for these smooth integrands.
+The cdf and its derivatives on the grid are computed once per \(s\) and the last few grids are cached,
+and each evaluation is a cubic Hermite interpolation.
+Parts with zero variance are constant shifts.
+)xyzyx";
+	template<variate_concept... V>
+		requires (sizeof...(V) >= 1)
+	class sum {
+		using V0 = std::tuple_element_t<0, std::tuple<V...>>;
+	public:
+		typedef typename V0::xtype xtype;
+		typedef typename V0::stype stype;
+	private:
+		using X = xtype;
+		using S = stype;
+		static_assert((std::is_same_v<typename V::xtype, X> and ...));
+		static_assert((std::is_same_v<typename V::stype, S> and ...));
+		static constexpr size_t m = sizeof...(V);
+		static constexpr X tail = X(1e-15); // mass of each part outside the grid
+
+		std::tuple<V...> v;
+		size_t n; // grid points
+
+		// F_s, its first three derivatives, and its integral at x_k = x0 + k h
+		struct grid {
+			S s;
+			X mean; // kappa'(s)
+			X shift; // sum of constant parts
+			size_t one; // index of the only part that is not constant, or m if none or more than one
+			size_t parts; // number of parts that are not constant
+			X x0, h;
+			std::vector<X> G[5]; // F, F', F'', F''', integral of F
+		};
+		mutable s_cache<grid> cache;
+
+		// f(i, v_i) for each part
+		template<class F>
+		void each(const F& f) const
+		{
+			std::apply([&f](const auto&... vi) {
+				size_t i = 0;
+				(f(i++, vi), ...);
+			}, v);
+		}
+
+		// cubic Hermite interpolation of y with derivative dy at x
+		static X hermite(const grid& g, const std::vector<X>& y, const std::vector<X>& dy, X x)
+		{
+			size_t N = y.size();
+			X t = (x - g.x0) / g.h;
+			size_t k = std::min(static_cast<size_t>(std::max(t, X(0))), N - 2);
+			t -= X(k);
+			X t2 = t * t, t3 = t2 * t;
+
+			return (2 * t3 - 3 * t2 + 1) * y[k] + (t3 - 2 * t2 + t) * g.h * dy[k]
+				+ (-2 * t3 + 3 * t2) * y[k + 1] + (t3 - t2) * g.h * dy[k + 1];
+		}
+
+		std::shared_ptr<const grid> build(S s) const
+		{
+			auto g = std::make_shared<grid>();
+			g->s = s;
+			g->mean = 0;
+			g->shift = 0;
+			g->one = m;
+			g->parts = 0;
+
+			X lo[m], hi[m];
+			each([&](size_t i, const auto& vi) {
+				X mi = vi.cumulant(s, 1);
+				g->mean += mi;
+				if (vi.cumulant(s, 2) > 0) {
+					lo[i] = quantile(vi, tail, s);
+					hi[i] = quantile(vi, 1 - tail, s);
+					if (g->parts++ == 0) {
+						g->one = i;
+					}
+				}
+				else {
+					lo[i] = hi[i] = 0;
+					g->shift += mi;
+				}
+			});
+			if (g->parts != 1) {
+				g->one = m;
+			}
+			if (g->parts < 2) {
+				return g;
+			}
+
+			// first part that is not constant and the density of the rest
+			size_t first = m;
+			X width = 0;
+			each([&](size_t i, const auto&) {
+				if (hi[i] > lo[i]) {
+					width += hi[i] - lo[i];
+					first = std::min(first, i);
+				}
+			});
+			X h = width / X(n - 1);
+			auto points = [&](size_t i) { return static_cast<size_t>(ceil((hi[i] - lo[i]) / h)) + 1; };
+			size_t n_rho = 1;
+			X x0 = g->shift + lo[first];
+			each([&](size_t i, const auto&) {
+				if (i != first and hi[i] > lo[i]) {
+					n_rho += points(i) - 1;
+					x0 += lo[i];
+				}
+			});
+			size_t N = points(first) + n_rho - 1;
+			size_t M = fft::pow2(N + n_rho);
+
+			// h rho(r_j) at r_j = sum of lo[i] + j h
+			std::vector<std::complex<X>> rho(M, X(0)), a(M);
+			rho[0] = 1;
+			fft::transform<X>(rho);
+			std::vector<X> x(M), y(M);
+			each([&](size_t i, const auto& vi) {
+				if (i != first and hi[i] > lo[i]) {
+					size_t ni = points(i);
+					for (size_t k = 0; k < ni; ++k) {
+						x[k] = lo[i] + X(k) * h;
+					}
+					variate::cdf(vi, std::span<const X>(x.data(), ni), s, 1, std::span<X>(y.data(), ni));
+					std::fill(a.begin(), a.end(), X(0));
+					for (size_t k = 0; k < ni; ++k) {
+						a[k] = h * y[k];
+					}
+					fft::transform<X>(a);
+					for (size_t k = 0; k < M; ++k) {
+						rho[k] *= a[k];
+					}
+				}
+			});
+
+			// F_1^{(j)}(lo[first] + i h) for -n_rho < i < N stored at i mod M
+			each([&](size_t i, const auto& vi) {
+				if (i == first) {
+					for (size_t k = 0; k < M; ++k) {
+						ptrdiff_t i_ = k < N ? ptrdiff_t(k) : ptrdiff_t(k) - ptrdiff_t(M);
+						x[k] = lo[i] + X(i_) * h;
+					}
+					for (unsigned j = 0; j < 4; ++j) {
+						variate::cdf(vi, std::span<const X>(x), s, j, std::span<X>(y));
+						for (size_t k = 0; k < M; ++k) {
+							a[k] = k < N or M - k < n_rho ? y[k] : X(0);
+						}
+						fft::transform<X>(a);
+						for (size_t k = 0; k < M; ++k) {
+							a[k] *= rho[k];
+						}
+						fft::transform<X>(a, true);
+						g->G[j].resize(N);
+						for (size_t k = 0; k < N; ++k) {
+							g->G[j][k] = a[k].real();
+						}
+					}
+				}
+			});
+
+			// integral of F using the trapezoidal rule with end correction
+			std::vector<X>& F = g->G[0];
+			std::vector<X>& f = g->G[1];
+			std::vector<X>& I = g->G[4];
+			I.resize(N);
+			I[0] = 0;
+			for (size_t k = 0; k + 1 < N; ++k) {
+				I[k + 1] = I[k] + h * (F[k] + F[k + 1]) / 2 + h * h * (f[k] - f[k + 1]) / 12;
+			}
+
+			g->x0 = x0;
+			g->h = h;
+
+			return g;
+		}
+
+		// cached grid for s
+		std::shared_ptr<const grid> at(S s) const
+		{
+			return cache.at(s, [this](S t) { return build(t); });
+		}
+
+		// F_s^{(j)}(x) for j <= 3 or the integral of F_s up to x for j = 4 using the grid
+		X value(const grid& g, X x, unsigned j) const
+		{
+			X x1 = g.x0 + X(g.G[0].size() - 1) * g.h;
+			if (x < g.x0) {
+				return 0;
+			}
+			if (x > x1) {
+				return j == 0 ? 1 : j == 4 ? g.G[4].back() + (x - x1) : 0;
+			}
+
+			return j == 4 ? hermite(g, g.G[4], g.G[0], x) : hermite(g, g.G[j], g.G[j + 1], x);
+		}
+		X eval(const grid& g, X x, unsigned n) const
+		{
+			if (g.parts == 0) {
+				return n == 0 ? X(g.shift <= x) : n == 1 and x == g.shift ? std::numeric_limits<X>::infinity() : 0;
+			}
+			if (g.parts == 1) {
+				X F = 0;
+				each([&](size_t i, const auto& vi) {
+					if (i == g.one) {
+						F = vi.cdf(x - g.shift, g.s, n);
+					}
+				});
+
+				return F;
+			}
+
+			return value(g, x, n);
+		}
+	public:
+		sum()
+			: v(), n(1 << 12)
+		{ }
+		sum(const V&... v)
+			: v(v...), n(1 << 12)
+		{ }
+		// use n grid points
+		sum(size_t n, const V&... v)
+			: v(v...), n(n)
+		{
+			ensure(n >= 4);
+		}
+
+		// part i
+		template<size_t i>
+		const auto& part() const
+		{
+			return std::get<i>(v);
+		}
+		const std::tuple<V...>& parts() const
+		{
+			return v;
+		}
+
+		// F_s^{(n)}(x) for n <= 2 when more than one part is not constant
+		X cdf(X x, S s = 0, unsigned n = 0) const
+		{
+			auto g = at(s);
+			ensure(g->parts < 2 or n <= 2);
+
+			return eval(*g, x, n);
+		}
+		// out[i] = cdf(x[i], s, n) using one grid, x and out may alias
+		void cdf(std::span<const X> x, S s, unsigned n, std::span<X> out) const
+		{
+			ensure(out.size() >= x.size());
+			auto g = at(s);
+			ensure(g->parts < 2 or n <= 2);
+
+			for (size_t i = 0; i < x.size(); ++i) {
+				out[i] = eval(*g, x[i], n);
+			}
+		}
+		void cdf_jet(X x, S s, unsigned N, std::span<X> out) const
+		{
+			ensure(out.size() > N);
+			auto g = at(s);
+			ensure(g->parts < 2 or N <= 2);
+
+			for (unsigned n = 0; n <= N; ++n) {
+				out[n] = eval(*g, x, n);
+			}
+		}
+
+		// sum of the cumulants of the parts
+		S cumulant(S s, unsigned n = 0) const
+		{
+			S k = 0;
+			each([&](size_t, const auto& vi) { k += vi.cumulant(s, n); });
+
+			return k;
+		}
+		std::complex<S> cumulant(std::complex<S> z) const
+			requires (variate_cumulant_complex_concept<V> and ...)
+		{
+			std::complex<S> k = 0;
+			each([&](size_t, const auto& vi) { k += vi.cumulant(z); });
+
+			return k;
+		}
+		void cumulant_jet(S s, unsigned N, std::span<S> out) const
+		{
+			ensure(out.size() > N);
+
+			std::vector<S> k(N + 1);
+			std::fill(out.begin(), out.begin() + N + 1, S(0));
+			each([&](size_t, const auto& vi) {
+				variate::cumulant_jet(vi, s, N, std::span<S>(k));
+				for (unsigned j = 0; j <= N; ++j) {
+					out[j] += k[j];
+				}
+			});
+		}
+
+		// sum of samples of the parts
+		template<std::uniform_random_bit_generator G>
+		void sample(G& g, std::span<X> out, S s = 0) const
+		{
+			std::vector<X> y(out.size());
+			std::fill(out.begin(), out.end(), X(0));
+			each([&](size_t, const auto& vi) {
+				variate::sample(vi, g, std::span<X>(y), s);
+				for (size_t i = 0; i < out.size(); ++i) {
+					out[i] += y[i];
+				}
+			});
+		}
+
+		// d/ds F_s(x) = E_s[1(X <= x)(X - kappa'(s))] = (x - kappa'(s)) F_s(x) - int_{-infty}^x F_s(y) dy
+		X edf(S s, X x) const
+		{
+			auto g = at(s);
+			if (g->parts == 0) {
+				return 0;
+			}
+			if (g->parts == 1) {
+				X e = 0;
+				each([&](size_t i, const auto& vi) {
+					if (i == g->one) {
+						e = vi.edf(s, x - g->shift);
+					}
+				});
+
+				return e;
+			}
+
+			return (x - g->mean) * value(*g, x, 0) - value(*g, x, 4);
+		}
+	};
+
+	template<class V>
+	struct is_sum : std::false_type {};
+	template<class... V>
+	struct is_sum<sum<V...>> : std::true_type {};
+
+	// parts of v as a tuple, sums are flattened
+	template<variate_concept V>
+	inline auto sum_parts(const V& v)
+	{
+		if constexpr (is_sum<V>::value) {
+			return v.parts();
+		}
+		else {
+			return std::tuple<V>(v);
+		}
+	}
+
+	// v + w is the sum of independent variates holding copies of the parts
+	template<variate_concept V, variate_concept W>
+		requires std::is_same_v<typename V::xtype, typename W::xtype>
+	inline auto operator+(const V& v, const W& w)
+	{
+		return std::apply([](const auto&... p) {
+			return sum<std::decay_t<decltype(p)>...>(p...);
+		}, std::tuple_cat(sum_parts(v), sum_parts(w)));
+	}
+
+}
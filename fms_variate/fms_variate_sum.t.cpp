@@ -0,0 +1,221 @@
+// fms_variate_sum.t.cpp - test sum of independent variates
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "fms_test.h"
+#include "fms_random.h"
+#include "fms_variate_sum.h"
+#include "fms_variate_constant.h"
+#include "fms_variate_discrete.h"
+#include "fms_variate_logistic.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+using namespace fms::variate;
+
+static_assert(variate_concept<sum<standard_normal<>, logistic<>>>);
+static_assert(variate_batch_concept<sum<standard_normal<>, logistic<>>>);
+
+template<class X>
+int test_variate_sum()
+{
+	standard_normal<X> N;
+	X s = X(0.3);
+	{
+		// N(0, 1) + N(0, 1) is N(0, 2) and X_s has mean 2s
+		sum<standard_normal<X>, standard_normal<X>> NN(N, N);
+		for (X x = -8; x <= 8; x += X(0.125)) {
+			X z = (x - 2 * s) / std::sqrt(X(2));
+			X f = std::exp(-z * z / 2) / std::sqrt(4 * X(3.14159265358979323846));
+			assert(fabs(NN.cdf(x, s) - std::erfc(-z * X(0.70710678118654752440)) / 2) < 1e-11);
+			assert(fabs(NN.cdf(x, s, 1) - f) < 1e-11);
+			assert(fabs(NN.cdf(x, s, 2) + z / std::sqrt(X(2)) * f) < 1e-11);
+			assert(fabs(NN.edf(s, x) + 2 * f) < 1e-10);
+		}
+		assert(NN.cumulant(s, 0) == s * s);
+		assert(NN.cumulant(s, 2) == 2);
+	}
+	{
+		logistic<X> L(X(1.5), 2);
+		constant<X> C(X(0.7));
+		sum<standard_normal<X>, logistic<X>, constant<X>> S(N, L, C);
+
+		// F(x) = int F_L(x - c - y, s) phi(y - s) dy using Simpson's rule
+		for (X x : { X(-6), X(-2), X(0), X(1), X(3), X(8) }) {
+			X h = X(0.002), I = 0;
+			int m = 12000;
+			for (int i = 0; i <= m; ++i) {
+				X y = s - 12 + i * h;
+				I += (i == 0 or i == m ? 1 : (i & 1) ? 4 : 2) * L.cdf(x - X(0.7) - y, s) * std::exp(-(y - s) * (y - s) / 2);
+			}
+			I *= h / 3 / std::sqrt(2 * X(3.14159265358979323846));
+			assert(fabs(S.cdf(x, s) - I) < 1e-10);
+
+			X ds = X(1e-4);
+			assert(fabs(S.edf(s, x) - (S.cdf(x, s + ds) - S.cdf(x, s - ds)) / (2 * ds)) < 1e-7);
+		}
+		X k[3];
+		S.cumulant_jet(s, 2, std::span<X>(k));
+		for (unsigned n = 0; n <= 2; ++n) {
+			X kn = N.cumulant(s, n) + L.cumulant(s, n) + C.cumulant(s, n);
+			assert(fabs(S.cumulant(s, n) - kn) < 1e-15);
+			assert(fabs(k[n] - kn) < 1e-14);
+		}
+
+		// batch uses the same grid
+		std::vector<X> x = { X(-30), X(-1), X(0.25), X(2), X(30) }, y(x.size());
+		for (unsigned n = 0; n <= 2; ++n) {
+			S.cdf(x, s, n, y);
+			for (size_t i = 0; i < x.size(); ++i) {
+				assert(y[i] == S.cdf(x[i], s, n));
+			}
+		}
+		assert(y.front() == 0 and y.back() == 0);
+
+		// copies share the grid and a new s builds a new one
+		auto S_ = S;
+		assert(S_.cdf(X(0.25), s) == S.cdf(X(0.25), s));
+		assert(S_.cdf(X(0.25), 0) != S.cdf(X(0.25), s));
+
+		X p = X(0.9);
+		assert(fabs(S.cdf(quantile(S, p, s), s) - p) < 1e-12);
+
+		random::philox g(7);
+		std::vector<X> z(100'000);
+		S.sample(g, std::span<X>(z), s);
+		X mean = 0;
+		for (X zi : z) {
+			mean += zi / X(z.size());
+		}
+		assert(fabs(mean - S.cumulant(s, 1)) < 5 * sqrt(S.cumulant(s, 2) / X(z.size())));
+	}
+	{
+		// one part that is not constant is exact
+		logistic<X> L(2, 1);
+		sum<logistic<X>, constant<X>> S(L, constant<X>(X(-1)));
+		assert(S.cdf(X(0.5), s) == L.cdf(X(1.5), s));
+		assert(S.cdf(X(0.5), s, 3) == L.cdf(X(1.5), s, 3));
+	}
+
+	return 0;
+}
+int test_variate_sum_d = test_variate_sum<double>();
+
+// c * X + mu and X + Y
+template<class X>
+int test_variate_algebra()
+{
+	logistic<X> L(2, 3);
+	standard_normal<X> N;
+	{
+		// nested affine transformations fold into one
+		auto A = (2 * L + 1) / 4 - X(0.5);
+		static_assert(std::is_same_v<decltype(A), affine<logistic<X>>>);
+		assert(A.location() == X(-0.25));
+		assert(A.scale() == X(0.5));
+		affine<logistic<X>> B(L, X(-0.25), X(0.5));
+		for (X x : { X(-2), X(0), X(1.5) }) {
+			assert(A.cdf(x, X(0.1), 1) == B.cdf(x, X(0.1), 1));
+		}
+	}
+	{
+		// affine of a temporary holds a copy
+		auto A = affine(logistic<X>(2, 3), X(1), X(2));
+		assert(A.cdf(X(1)) == L.cdf(X(0)));
+	}
+	{
+		// sums are flattened
+		auto S = N + L + constant<X>(X(0.5));
+		static_assert(std::is_same_v<decltype(S), sum<standard_normal<X>, logistic<X>, constant<X>>>);
+		sum<standard_normal<X>, logistic<X>, constant<X>> S_(N, L, constant<X>(X(0.5)));
+		assert(S.cumulant(X(0.2), 2) == S_.cumulant(X(0.2), 2));
+		assert(S.cdf(X(1), X(0.2)) == S_.cdf(X(1), X(0.2)));
+
+		auto T = 2 * N + (L + 1);
+		static_assert(std::is_same_v<decltype(T), sum<affine<standard_normal<X>>, affine<logistic<X>>>>);
+		assert(fabs(T.cumulant(X(0.2), 1) - (4 * X(0.2) + L.cumulant(X(0.2), 1) + 1)) < 1e-14);
+	}
+	{
+		// negative scales reflect the cdf
+		auto A = 1 - 2 * L;
+		static_assert(std::is_same_v<decltype(A), affine<logistic<X>>>);
+		assert(A.scale() == -2);
+		X s = X(0.1), ds = X(1e-5);
+		for (X x : { X(-3), X(0), X(1), X(2.5) }) {
+			X y = (1 - x) / 2;
+			assert(fabs(A.cdf(x, s) - (1 - L.cdf(y, -2 * s))) < 1e-15);
+			X dF = (A.cdf(x + ds, s) - A.cdf(x - ds, s)) / (2 * ds);
+			assert(fabs(A.cdf(x, s, 1) - dF) < 1e-9);
+			X F[3];
+			A.cdf_jet(x, s, 2, std::span<X>(F));
+			assert(F[0] == A.cdf(x, s));
+			assert(fabs(F[1] - A.cdf(x, s, 1)) < 1e-15);
+			assert(fabs(F[2] - A.cdf(x, s, 2)) < 1e-15);
+			X dFs = (A.cdf(x, s + ds) - A.cdf(x, s - ds)) / (2 * ds);
+			assert(fabs(A.edf(s, x) - dFs) < 1e-9);
+			assert(fabs(A.cdf(A.quantile(A.cdf(x, s), s), s) - A.cdf(x, s)) < 1e-12);
+		}
+		assert(fabs(A.cumulant(s) - (s + L.cumulant(-2 * s))) < 1e-15);
+		assert(fabs(A.cumulant(s, 2) - 4 * L.cumulant(-2 * s, 2)) < 1e-14);
+
+		// atoms are included in P(-X <= x)
+		X x[] = { 0, 1 };
+		X p[] = { X(0.7), X(0.3) };
+		auto B = -discrete<X>(2, x, p);
+		assert(B.cdf(-2) == 0);
+		assert(fabs(B.cdf(-1) - X(0.3)) < 1e-15);
+		assert(B.cdf(X(-0.5)) == B.cdf(-1));
+		assert(B.cdf(0) == 1);
+		std::vector<X> y = { -1, 0 }, F(2);
+		B.cdf(y, 0, 0, F);
+		assert(F[0] == B.cdf(-1) and F[1] == B.cdf(0));
+		assert(B.quantile(X(0.3)) == -1);
+		assert(B.quantile(X(0.31)) == 0);
+		assert(B.quantile(1) == 0);
+
+		// zero scale
+		bool thrown = false;
+		try {
+			affine<logistic<X>> C(L, 1, 0);
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	return 0;
+}
+int test_variate_algebra_d = test_variate_algebra<double>();
+
+// one grid per s then O(1) per x
+template<class X>
+int benchmark_variate_sum()
+{
+	standard_normal<X> N;
+	logistic<X> L(X(1.5), 2);
+	constexpr size_t n = 1 << 16;
+	std::vector<X> x(n), y(n);
+	for (size_t i = 0; i < n; ++i) {
+		x[i] = -10 + 20 * X(i) / n;
+	}
+
+	double ms_grid = test::time([&]() { sum<standard_normal<X>, logistic<X>>(N, L).cdf(0); });
+	sum<standard_normal<X>, logistic<X>> S(N, L);
+	S.cdf(0);
+	double ms_x = test::time([&]() { S.cdf(x, 0, 0, y); });
+	assert(ms_x < ms_grid * n / 100);
+
+	// central differences in s reuse the grids
+	X s = X(0.1), ds = X(1e-4), dF = 0;
+	double ms_s = test::time([&]() {
+		for (int k = 0; k < 20; ++k) {
+			dF += S.cdf(0, s + ds) - S.cdf(0, s - ds) + S.cdf(0, s);
+		}
+	});
+	assert(ms_s < 5 * ms_grid); // three grids
+
+	return ms_x < ms_grid and dF != 0;
+}
+int benchmark_variate_sum_d = benchmark_variate_sum<double>();
@@ -4,17 +4,16 @@
 
 using namespace xll;
 using namespace fms::sf;
-using fms::sf::list;
 
 AddIn xai_hypergeometric(
 	Function(XLL_FP, "xll_hypergeometric", "HYPERGEOMETRIC")
 	.Arguments({
-		{XLL_FP, "a", "is an array of p numbers.", "1"},
-		{XLL_FP, "b", "is an array of q numbers.", "1" },
-		{XLL_DOUBLE, "x", "is the value at which to evaluate the function.", "1"},
+		{XLL_FP, "a", "is an array of p numbers or p columns with one row per x.", "1"},
+		{XLL_FP, "b", "is an array of q numbers or q columns with one row per x.", "1" },
+		{XLL_FP, "x", "is an array of values at which to evaluate the function.", "1"},
 		{XLL_BOOL, "regularized?", "return regularized value. Default is FALSE.", "FALSE"},
 	})
-	.FunctionHelp("Return hypergeometric pFq(x) value.")
+	.FunctionHelp("Return hypergeometric pFq(x) value, tail error, small terms, and iterations for each x.")
 	.Category("XLL")
 	.Documentation(R"xyzyx(
 The generalized hypergeometric function is
@@ -23,22 +22,58 @@ The generalized hypergeometric function is
 	= \sum_{n=0}^\infty \frac{\Pi_{j=1}^p (a_j)_n}}{\Pi_{k=1}^q (b_k)_n} \frac{x^n}{n!}
 \]
 where \((a)_n} = \Gamma(a + n)/\Gamma(a) = a (a + 1) \cdots (a + n - 1)\) is the rising Pochhammer symbol.
+The result has 4 rows and one column for each of the \(N\) values of \(x\): the value, the last term
+added, the number of terms that were small relative to the sum, and the number of terms.
+If \(N > 1\) and both <code>a</code> and <code>b</code> have \(N\) rows then row \(j\) is the
+parameters used for \(x_j\), otherwise the same parameters are used for every \(x\).
+Enter shared parameters as a single row.
 )xyzyx")
 );
-_FPX* WINAPI xll_hypergeometric(_FPX* pa, _FPX* pb, double x, BOOL regularized)
+_FPX* WINAPI xll_hypergeometric(_FPX* pa, _FPX* pb, _FPX* px, BOOL regularized)
 {
 #pragma XLLEXPORT
-	static FPX result(4,1);
+	static FPX result;
 
 	try {
-		auto a = list<double>(begin(*pa), end(*pa));
-		auto b = list<double>(begin(*pb), end(*pb));
-		Hypergeometric<double> pFq(a, b);
+		size_t N = size(*px);
+		std::span<const double> x(px->array, N);
+		result.resize(4, static_cast<int>(N));
+		std::span<double> out(result.begin(), result.size());
 
-		std::tie(result[0], result[1], result[2], result[3]) = pFq.value(x);
+		if (N > 1 and static_cast<size_t>(pa->rows) == N and static_cast<size_t>(pb->rows) == N) {
+			// column i of a is a_i for each x
+			auto soa = [N](const _FPX* pa) {
+				std::vector<std::vector<double>> a(pa->columns, std::vector<double>(N));
+				for (size_t j = 0; j < N; ++j) {
+					for (size_t i = 0; i < a.size(); ++i) {
+						a[i][j] = pa->array[j * pa->columns + i];
+					}
+				}
+				return a;
+			};
+			auto a = soa(pa), b = soa(pb);
+			std::vector<std::span<const double>> a_(a.begin(), a.end()), b_(b.begin(), b.end());
+			HypergeometricPFQ(a_, b_, x, out);
 
-		if (regularized) {
-			result[0] = pFq.regularized();
+			if (regularized) {
+				for (size_t j = 0; j < N; ++j) {
+					for (const auto& bi : b) {
+						out[j] /= std::tgamma(bi[j]);
+					}
+				}
+			}
+		}
+		else {
+			Hypergeometric<double> pFq{ std::span<const double>(begin(*pa), end(*pa)), std::span<const double>(begin(*pb), end(*pb)) };
+			pFq.value(x, out);
+
+			if (regularized) {
+				for (size_t j = 0; j < N; ++j) {
+					for (double bi : pFq.denominator()) {
+						out[j] /= std::tgamma(bi);
+					}
+				}
+			}
 		}
 	}
 	catch (const std::exception& ex) {
@@ -46,4 +81,4 @@ _FPX* WINAPI xll_hypergeometric(_FPX* pa, _FPX* pb, double x, BOOL regularized)
 	}
 
 	return result.get();
-}
\ No newline at end of file
+}
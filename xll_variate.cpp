@@ -25,12 +25,7 @@ static AddIn xai_variate_affine(
 	.Uncalced()
 	.FunctionHelp("Return a handle to the variate μ + σX.")
 	.Category(XLL_CATEGORY)
-	.Documentation(R"xyzyx(
-Returns the \(n\)-th derivative of the Esscher transformed cumulative distrubution.
-The <em>Esscher transform</em> of the density function \(f\) of a random variable \(X\) is 
-\(f_s(x) = f(x)e^{sX - \kappa(s)}\) whenever the <a href="VARIATE.CUMULANT.html">cumulant</a> 
-\(\kappa(s)\) exists.
-)xyzyx")
+	.Documentation(affine_doc)
 );
 HANDLEX WINAPI xll_variate_affine(HANDLEX h, double a, double b)
 {
@@ -38,9 +33,13 @@ HANDLEX WINAPI xll_variate_affine(HANDLEX h, double a, double b)
 	HANDLEX hab = INVALID_HANDLEX;
 
 	try {
+		if (b == 0) {
+			b = 1;
+		}
+
 		handle<variate_base<>> h_(h);
 		ensure(h_);
-		handle<variate_base<>> v(new variate_handle(affine(*h_.ptr(), a, b)));
+		handle<variate_base<>> v(h_->location_scale(a, b).release());
 		hab = v.get();
 	}
 	catch (const std::exception& ex) {
@@ -72,7 +71,7 @@ HANDLEX WINAPI xll_variate_normalize(HANDLEX h)
 		ensure(h_);
 		double m = h_->cumulant(0, 1);  // mean
 		double s = sqrt(h_->cumulant(0, 2)); // standard deviation
-		handle<variate_base<>> v(new variate_handle(affine(*h_.ptr(), -m/s, 1/s)));
+		handle<variate_base<>> v(h_->location_scale(-m/s, 1/s).release());
 		_h = v.get();
 	}
 	catch (const std::exception& ex) {
@@ -82,118 +81,222 @@ HANDLEX WINAPI xll_variate_normalize(HANDLEX h)
 	return _h;
 }
 
+static AddIn xai_variate_tilt(
+	Function(XLL_HANDLE, "xll_variate_tilt", "\\VARIATE.TILT")
+	.Arguments({
+		Arg(XLL_HANDLE, "h", "is a handle to a variate.", "\"=\\VARIATE.LOGISTIC(1,1)\""),
+		Arg(XLL_DOUBLE, "s", "is the Esscher transform parameter.", "0"),
+		})
+	.Uncalced()
+	.FunctionHelp("Return a handle to the Esscher transformed variate X_s.")
+	.Category(XLL_CATEGORY)
+	.Documentation(tilt_doc)
+);
+HANDLEX WINAPI xll_variate_tilt(HANDLEX h, double s)
+{
+#pragma XLLEXPORT
+	HANDLEX hs = INVALID_HANDLEX;
+
+	try {
+		handle<variate_base<>> h_(h);
+		ensure(h_);
+		handle<variate_base<>> v(h_->tilt(s).release());
+		hs = v.get();
+	}
+	catch (const std::exception& ex) {
+		XLL_ERROR(ex.what());
+	}
+
+	return hs;
+}
+
 static AddIn xai_variate_cdf(
-	Function(XLL_DOUBLE, "xll_variate_cdf", "VARIATE.CDF")
+	Function(XLL_FP, "xll_variate_cdf", "VARIATE.CDF")
 	.Arguments({
 		Arg(XLL_HANDLE, "m", "is a handle to the variate", "\"=\\VARIATE.NORMAL(0,1)\""),
-		Arg(XLL_DOUBLE, "x", "is the value", "0"),
+		Arg(XLL_FP, "x", "is an array of values", "0"),
 		Arg(XLL_DOUBLE, "s", "is the Esscher transform parameter. Default is 0.", "0"),
 		Arg(XLL_WORD, "n", "is the derivative. Default is 0.", "0")
 		})
-	.FunctionHelp("Return the n-th derivative of the transformed cumulative distribution function at x.")
+	.FunctionHelp("Return the n-th derivative of the transformed cumulative distribution function at each x.")
 	.Category(XLL_CATEGORY)
 	.Documentation(cdf_doc)
 );
-double WINAPI xll_variate_cdf(HANDLEX m, double x, double s, WORD n)
+_FPX* WINAPI xll_variate_cdf(HANDLEX m, _FPX* px, double s, WORD n)
+{
+#pragma XLLEXPORT
+	static FPX result;
+
+	try {
+		handle<variate_base<>> m_(m);
+		ensure(m_);
+		result.resize(px->rows, px->columns);
+		m_->cdf(std::span<const double>(px->array, size(*px)), s, n, std::span<double>(result.begin(), result.size()));
+	}
+	catch (const std::exception& ex) {
+		XLL_ERROR(ex.what());
+		result.resize(1, 1);
+		result[0] = XLL_NAN;
+	}
+
+	return result.get();
+}
+
+static AddIn xai_variate_jet(
+	Function(XLL_FP, "xll_variate_jet", "VARIATE.JET")
+	.Arguments({
+		Arg(XLL_HANDLE, "m", "is a handle to the variate", "\"=\\VARIATE.NORMAL(0,1)\""),
+		Arg(XLL_DOUBLE, "x", "is the value", "0"),
+		Arg(XLL_DOUBLE, "s", "is the Esscher transform parameter. Default is 0.", "0"),
+		Arg(XLL_WORD, "N", "is the highest derivative. Default is 0.", "0")
+		})
+	.FunctionHelp("Return the 0 to N-th derivatives of the transformed cumulative distribution function at x.")
+	.Category(XLL_CATEGORY)
+	.Documentation(cdf_jet_doc)
+);
+_FPX* WINAPI xll_variate_jet(HANDLEX m, double x, double s, WORD N)
+{
+#pragma XLLEXPORT
+	static FPX result;
+
+	try {
+		handle<variate_base<>> m_(m);
+		ensure(m_);
+		result.resize(N + 1, 1);
+		m_->cdf_jet(x, s, N, std::span<double>(result.begin(), result.size()));
+	}
+	catch (const std::exception& ex) {
+		XLL_ERROR(ex.what());
+		result.resize(1, 1);
+		result[0] = XLL_NAN;
+	}
+
+	return result.get();
+}
+
+static AddIn xai_variate_quantile(
+	Function(XLL_FP, "xll_variate_quantile", "VARIATE.QUANTILE")
+	.Arguments({
+		Arg(XLL_HANDLE, "m", "is a handle to the variate", "\"=\\VARIATE.NORMAL(0,1)\""),
+		Arg(XLL_FP, "p", "is an array of probabilities", "0.5"),
+		Arg(XLL_DOUBLE, "s", "is the Esscher transform parameter. Default is 0.", "0"),
+		})
+	.FunctionHelp("Return the inverse of the transformed cumulative distribution function at each p.")
+	.Category(XLL_CATEGORY)
+	.Documentation(quantile_doc)
+);
+_FPX* WINAPI xll_variate_quantile(HANDLEX m, _FPX* pp, double s)
 {
 #pragma XLLEXPORT
-	double result = XLL_NAN;
+	static FPX result;
 
 	try {
 		handle<variate_base<>> m_(m);
 		ensure(m_);
-		result = m_->cdf(x, s, n);
+		result.resize(pp->rows, pp->columns);
+		m_->quantile(std::span<const double>(pp->array, size(*pp)), s, std::span<double>(result.begin(), result.size()));
 	}
 	catch (const std::exception& ex) {
 		XLL_ERROR(ex.what());
+		result.resize(1, 1);
+		result[0] = XLL_NAN;
 	}
 
-	return result;
+	return result.get();
 }
 
 static AddIn xai_variate_pdf(
-	Function(XLL_DOUBLE, "xll_variate_pdf", "VARIATE.PDF")
+	Function(XLL_FP, "xll_variate_pdf", "VARIATE.PDF")
 	.Arguments({
 		Arg(XLL_HANDLE, "m", "is a handle to the variate.", "\"=\\VARIATE.NORMAL(0,1)\""),
-		Arg(XLL_DOUBLE, "x", "is the value.", "0"),
+		Arg(XLL_FP, "x", "is an array of values.", "0"),
 		Arg(XLL_DOUBLE, "s", "is the Esscher transform parameter. Default is 0.", "0"),
 		})
-	.FunctionHelp("Return the transformed probability density at x.")
+	.FunctionHelp("Return the transformed probability density at each x.")
 	.Category(XLL_CATEGORY)
 	.Documentation(R"(
 The probability density function is the derivative of the
 cumulative distribution function.
 )")
 );
-double WINAPI xll_variate_pdf(HANDLEX m, double x, double s)
+_FPX* WINAPI xll_variate_pdf(HANDLEX m, _FPX* px, double s)
 {
 #pragma XLLEXPORT
-	double result = XLL_NAN;
+	static FPX result;
 
 	try {
 		handle<variate_base<>> m_(m);
 		ensure(m_);
-		result = m_->cdf(x, s, 1);
+		result.resize(px->rows, px->columns);
+		m_->cdf(std::span<const double>(px->array, size(*px)), s, 1, std::span<double>(result.begin(), result.size()));
 	}
 	catch (const std::exception& ex) {
 		XLL_ERROR(ex.what());
+		result.resize(1, 1);
+		result[0] = XLL_NAN;
 	}
 
-	return result;
+	return result.get();
 }
 
 static AddIn xai_variate_cumulant(
-	Function(XLL_DOUBLE, "xll_variate_cumulant", "VARIATE.CUMULANT")
+	Function(XLL_FP, "xll_variate_cumulant", "VARIATE.CUMULANT")
 	.Arguments({
 		Arg(XLL_HANDLE, "m", "is a handle to the variate.", "\"=\\VARIATE.NORMAL(0,1)\""),
-		Arg(XLL_DOUBLE, "s", "is the value.", "0"),
+		Arg(XLL_FP, "s", "is an array of values.", "0"),
 		Arg(XLL_WORD, "n", "is the derivative. Default is 0.", "0")
 		})
-	.FunctionHelp("Return n-th derivative of cumulant at s.")
+	.FunctionHelp("Return n-th derivative of cumulant at each s.")
 	.Category(XLL_CATEGORY)
 	.Documentation(cumulant_doc)
 );
-double WINAPI xll_variate_cumulant(HANDLEX m, double s, WORD n)
+_FPX* WINAPI xll_variate_cumulant(HANDLEX m, _FPX* ps, WORD n)
 {
 #pragma XLLEXPORT
-	double result = XLL_NAN;
+	static FPX result;
 
 	try {
 		handle<variate_base<>> m_(m);
 		ensure(m_);
-		result = m_->cumulant(s, n);
+		result.resize(ps->rows, ps->columns);
+		m_->cumulant(std::span<const double>(ps->array, size(*ps)), n, std::span<double>(result.begin(), result.size()));
 	}
 	catch (const std::exception& ex) {
 		XLL_ERROR(ex.what());
+		result.resize(1, 1);
+		result[0] = XLL_NAN;
 	}
 
-	return result;
+	return result.get();
 }
 
 static AddIn xai_variate_edf(
-	Function(XLL_DOUBLE, "xll_variate_edf", "VARIATE.EDF")
+	Function(XLL_FP, "xll_variate_edf", "VARIATE.EDF")
 	.Arguments({
 		Arg(XLL_HANDLE, "m", "is a handle to the variate.", "\"=\\VARIATE.NORMAL(0,1)\""),
 		Arg(XLL_DOUBLE, "s", "is the Esscher transform parameter. Default is 0.", "0"),
-		Arg(XLL_DOUBLE, "x", "is the value.", "0"),
+		Arg(XLL_FP, "x", "is an array of values.", "0"),
 		})
-	.FunctionHelp("Return the derivative of the transformed distribution with respect to s.")
+	.FunctionHelp("Return the derivative of the transformed distribution with respect to s at each x.")
 	.Category(XLL_CATEGORY)
 	.Documentation(edf_doc)
 );
-double WINAPI xll_variate_edf(HANDLEX m, double s, double x)
+_FPX* WINAPI xll_variate_edf(HANDLEX m, double s, _FPX* px)
 {
 #pragma XLLEXPORT
-	double result = XLL_NAN;
+	static FPX result;
 
 	try {
 		handle<variate_base<>> m_(m);
 		ensure(m_);
-		result = m_->edf(s, x);
+		result.resize(px->rows, px->columns);
+		m_->edf(s, std::span<const double>(px->array, size(*px)), std::span<double>(result.begin(), result.size()));
 	}
 	catch (const std::exception& ex) {
 		XLL_ERROR(ex.what());
+		result.resize(1, 1);
+		result[0] = XLL_NAN;
 	}
 
-	return result;
+	return result.get();
 }
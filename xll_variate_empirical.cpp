@@ -0,0 +1,32 @@
+// xll_variate_empirical.cpp - Excel add-in for empirical variates
+#include "fms_variate/fms_variate_empirical.h"
+#include "xll_variate.h"
+
+using namespace fms::variate;
+using namespace xll;
+
+AddIn xai_variate_empirical(
+	Function(XLL_HANDLE, "xll_variate_empirical", "\\VARIATE.EMPIRICAL")
+	.Arguments({
+		Arg(XLL_CSTRING, "file", "is the path of a binary file of doubles."),
+		})
+	.Uncalced()
+	.FunctionHelp("Return handle to the empirical variate of the samples in file.")
+	.Category(XLL_CATEGORY)
+	.Documentation(fms::variate::empirical_doc)
+);
+HANDLEX WINAPI xll_variate_empirical(xcstr file)
+{
+#pragma XLLEXPORT
+	HANDLEX h = INVALID_HANDLEX;
+
+	try {
+		handle<variate_base<>> v(new variate_handle(empirical<>(file)));
+		h = v.get();
+	}
+	catch (const std::exception& ex) {
+		XLL_ERROR(ex.what());
+	}
+
+	return h;
+}
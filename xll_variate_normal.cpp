@@ -27,6 +27,10 @@ HANDLEX WINAPI xll_variate_normal(double mu, double sigma)
 	HANDLEX h = INVALID_HANDLEX;
 
 	try {
+		if (sigma == 0) {
+			sigma = 1;
+		}
+
 		handle<variate_base<>> v(new variate_handle(affine(standard_normal<>{}, mu, sigma)));
 		h = v.get();
 	}